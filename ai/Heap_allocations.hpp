@@ -0,0 +1,63 @@
+#ifndef AI_HEAP_ALLOCATIONS_HPP_
+#define AI_HEAP_ALLOCATIONS_HPP_
+
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+/**
+ * Replaces the global operator new and operator delete to count the heap allocations of a program, for the
+ * benchmarks and the examples. Replacement operators can't be inline: include this header in exactly one
+ * translation unit of a program.
+ */
+
+namespace detail
+{
+
+	inline std::atomic<unsigned long>& allocation_count() noexcept
+	{
+		static std::atomic<unsigned long> count(0);
+		return count;
+	}
+
+}
+
+/**
+ * @return The number of calls to operator new since the program started
+ */
+inline unsigned long heap_allocations() noexcept
+{
+	return detail::allocation_count().load(std::memory_order_relaxed);
+}
+
+// GCC flags the replacement operator delete when it's inlined into code using the replaced operator new
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+	detail::allocation_count().fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size != 0 ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -9,6 +9,183 @@
 #include <functional>
 #include <queue>
 #include <iterator>
+#include <cstddef>
+
+namespace detail
+{
+
+	/**
+	 * Bipartite graph between the variables of an all-different constraint and their values, filtered with
+	 * Régin's algorithm ("A filtering algorithm for constraints of difference in CSPs"): given a matching
+	 * covering all the variables, an edge belongs to some other such matching, and the value is consistent,
+	 * only if it's matched, it's on an alternating path from a free value or both its ends are in the same
+	 * strongly connected component of the graph where matched edges go from variables to values and the others
+	 * from values to variables.
+	 */
+	class Value_graph
+	{
+	public:
+		void reset(std::size_t variables, std::size_t values)
+		{
+			variables_ = variables;
+			values_ = values;
+			edges_.assign(variables * values, 0);
+			variable_match_.assign(variables, none);
+			value_match_.assign(values, none);
+		}
+		void add_edge(std::size_t variable, std::size_t value) { edges_[variable * values_ + value] = 1; }
+		/**
+		 * @return False if no matching covers all the variables, which means the constraint can't be satisfied
+		 */
+		bool match()
+		{
+			for (std::size_t variable = 0; variable < variables_; ++variable)
+			{
+				visited_.assign(values_, 0);
+				if (!augment(variable))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		/**
+		 * @brief Marks the consistent edges, to be called after match
+		 */
+		void filter()
+		{
+			const std::size_t nodes = variables_ + values_;
+			// Nodes reachable from the free values along alternating paths
+			reachable_.assign(nodes, 0);
+			stack_.clear();
+			for (std::size_t value = 0; value < values_; ++value)
+			{
+				if (value_match_[value] == none)
+				{
+					reachable_[variables_ + value] = 1;
+					stack_.push_back(variables_ + value);
+				}
+			}
+			while (!stack_.empty())
+			{
+				const std::size_t node = stack_.back();
+				stack_.pop_back();
+				for_each_successor(node, [this](std::size_t next)
+						{
+							if (!reachable_[next])
+							{
+								reachable_[next] = 1;
+								stack_.push_back(next);
+							}
+						});
+			}
+			// Strongly connected components (Tarjan)
+			component_.assign(nodes, none);
+			order_.assign(nodes, none);
+			low_.assign(nodes, 0);
+			stack_.clear();
+			counter_ = 0;
+			components_ = 0;
+			for (std::size_t node = 0; node < nodes; ++node)
+			{
+				if (order_[node] == none)
+				{
+					connect(node);
+				}
+			}
+		}
+		bool consistent(std::size_t variable, std::size_t value) const
+		{
+			const std::size_t value_node = variables_ + value;
+			return variable_match_[variable] == value || reachable_[value_node]
+					|| component_[variable] == component_[value_node];
+		}
+	private:
+		enum : std::size_t { none = static_cast<std::size_t>(-1) };
+
+		bool edge(std::size_t variable, std::size_t value) const { return edges_[variable * values_ + value] != 0; }
+		bool augment(std::size_t variable)
+		{
+			for (std::size_t value = 0; value < values_; ++value)
+			{
+				if (edge(variable, value) && !visited_[value])
+				{
+					visited_[value] = 1;
+					if (value_match_[value] == none || augment(value_match_[value]))
+					{
+						variable_match_[variable] = value;
+						value_match_[value] = variable;
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+		/**
+		 * Variables point to their matched value, values to the variables they aren't matched with
+		 */
+		template <typename F>
+		void for_each_successor(std::size_t node, F f) const
+		{
+			if (node < variables_)
+			{
+				f(variables_ + variable_match_[node]);
+				return;
+			}
+			const std::size_t value = node - variables_;
+			for (std::size_t variable = 0; variable < variables_; ++variable)
+			{
+				if (edge(variable, value) && variable_match_[variable] != value)
+				{
+					f(variable);
+				}
+			}
+		}
+		void connect(std::size_t node)
+		{
+			order_[node] = low_[node] = counter_++;
+			stack_.push_back(node);
+			for_each_successor(node, [this, node](std::size_t next)
+					{
+						if (order_[next] == none)
+						{
+							connect(next);
+							low_[node] = std::min(low_[node], low_[next]);
+						}
+						else if (component_[next] == none)
+						{
+							low_[node] = std::min(low_[node], order_[next]);
+						}
+					});
+			if (low_[node] == order_[node])
+			{
+				std::size_t member;
+				do
+				{
+					member = stack_.back();
+					stack_.pop_back();
+					component_[member] = components_;
+				} while (member != node);
+				++components_;
+			}
+		}
+
+		std::size_t variables_ = 0;
+		std::size_t values_ = 0;
+		std::vector<unsigned char> edges_;
+		std::vector<std::size_t> variable_match_;
+		std::vector<std::size_t> value_match_;
+		std::vector<unsigned char> visited_;
+		std::vector<unsigned char> reachable_;
+		std::vector<std::size_t> component_;
+		std::vector<std::size_t> order_;
+		std::vector<std::size_t> low_;
+		std::vector<std::size_t> stack_;
+		std::size_t counter_ = 0;
+		std::size_t components_ = 0;
+	};
+
+}
 
 /**
  * Policy to decide the variables' order of evaluation: first the ones with the smallest domain
@@ -28,8 +205,8 @@ class First_order_policy
 {
 protected:
 	~First_order_policy() = default;
-    template <typename K, typename T>
-	std::vector<T> list(const Cnft_variable<K, T>&, const Cnft_assignment<K, T>&) const;
+    template <typename K, typename T, typename Relation>
+	std::vector<T> list(const Cnft_variable<K, T>&, const Cnft_assignment<K, T>&, const Csp<K, T, Relation>&) const;
 };
 
 /**
@@ -39,29 +216,58 @@ class LCV_order_policy
 {
 protected:
 	~LCV_order_policy() = default;
-    template <typename K, typename T>
-	std::vector<T> list(Cnft_variable<K, T>&, const Cnft_assignment<K, T>&) const;
+    template <typename K, typename T, typename Relation>
+	std::vector<T> list(const Cnft_variable<K, T>&, const Cnft_assignment<K, T>&, const Csp<K, T, Relation>&) const;
 };
 
 /**
- * Ensures arc-consistency
+ * Ensures arc-consistency after a variable is assigned (maintaining arc consistency), and generalized
+ * arc consistency of the all-different constraints
  */
 class AC3_consistency
 {
 public:
 	/**
+	 * @brief Removes from the domains the values left without support, recording the changes on trail
 	 * @return False if an inconsistency is found, otherwise true
 	 */
-    template <typename K, typename T>
-	bool revise(const Cnft_variable<K, T>&, Cnft_assignment<K, T>&) const;
+    template <typename K, typename T, typename Relation>
+	bool revise(const Cnft_variable<K, T>&,
+			Cnft_assignment<K, T>&,
+			const Csp<K, T, Relation>&,
+			Domain_trail<T>& trail) const;
 protected:
     ~AC3_consistency() = default;
 private:
+    /**
+     * Arc revising the domain of target against the variable at the other end
+     */
+    template <typename K, typename T, typename Relation>
+    struct Revision
+    {
+    	std::size_t target;
+    	typename Csp<K, T, Relation>::Arc arc;
+    };
     /**
      * @return True if any change occurred
      */
-    template <typename K, typename T>
-    bool revise(const Binary_constraint<K, T>&, Cnft_assignment<K, T>&) const;
+    template <typename K, typename T, typename Relation>
+    bool revise(const Revision<K, T, Relation>&,
+    		Cnft_assignment<K, T>&,
+			const Csp<K, T, Relation>&,
+			Domain_trail<T>& trail) const;
+    /**
+     * @brief Removes the values of the variables of an all-different constraint which can't be part of any solution
+     * of the constraint, and appends the variables whose domain changed to changed
+     * @return False if the constraint can't be satisfied
+     */
+    template <typename K, typename T, typename Relation>
+    bool revise_all_different(std::size_t group,
+    		Cnft_assignment<K, T>&,
+			const Csp<K, T, Relation>&,
+			Domain_trail<T>& trail,
+			detail::Value_graph& graph,
+			std::vector<std::size_t>& changed) const;
 };
 
 template <typename Inference_policy = AC3_consistency,
@@ -74,23 +280,35 @@ class Backtracking_solver : protected Inference_policy,
     template <typename K, typename T>
     using Assignment_ptr = std::unique_ptr<Cnft_assignment<K, T>>;
 public:
-    template <typename K, typename T>
-    Assignment_ptr<K, T> operator()(const Csp<K, T>& csp) const
+    template <typename K, typename T, typename Relation>
+    Assignment_ptr<K, T> operator()(const Csp<K, T, Relation>& csp) const
     {
-        Cnft_assignment<K, T> start_assignment = detail::assignment_from_variables<Cnft_assignment>(csp.variables());
-        return backtrack(start_assignment, csp);
+        Cnft_assignment<K, T> start_assignment = detail::assignment_from_variables<Cnft_assignment>(csp.variables(),
+        		csp.indices());
+        Domain_trail<T> trail;
+        nodes_ = 0;
+        return backtrack(start_assignment, csp, trail);
     }
+    /**
+     * @return Number of values assigned during the last search
+     */
+    unsigned long long nodes() const noexcept { return nodes_; }
 private:
-    template <typename K, typename T>
-    Assignment_ptr<K, T> backtrack(Cnft_assignment<K, T>& assignment, const Csp<K, T>& csp) const;
+    template <typename K, typename T, typename Relation>
+    Assignment_ptr<K, T> backtrack(Cnft_assignment<K, T>& assignment,
+    		const Csp<K, T, Relation>& csp,
+			Domain_trail<T>& trail) const;
+
+    mutable unsigned long long nodes_ = 0;
 };
 
 template <typename Inference_policy, typename Select_var_policy, typename Value_order_policy>
-template <typename K, typename T>
+template <typename K, typename T, typename Relation>
 Backtracking_solver<Inference_policy, Select_var_policy, Value_order_policy>::Assignment_ptr<K, T>
 Backtracking_solver<Inference_policy, Select_var_policy, Value_order_policy>::backtrack(
 		Cnft_assignment<K, T>& assignment,
-		const Csp<K, T>& csp) const
+		const Csp<K, T, Relation>& csp,
+		Domain_trail<T>& trail) const
 {
     if (is_complete(assignment))
     {
@@ -99,20 +317,24 @@ Backtracking_solver<Inference_policy, Select_var_policy, Value_order_policy>::ba
 
     auto* variable = &Select_var_policy::next(assignment);
 
-    for (const auto& value : Value_order_policy::list(*variable, assignment))
+    for (const auto& value : Value_order_policy::list(*variable, assignment, csp))
     {
-		const auto old_assignment = assignment;
+    	// Undoing the changes recorded on the trail is enough to go back, the assignment is never copied
+		const auto mark = trail.mark();
+		++nodes_;
 		variable->assign(value);
+		trail.reduce_to(variable->domain(), variable->domain().find(value).position());
 
-		if (Inference_policy::revise(*variable, assignment))
+		if (Inference_policy::revise(*variable, assignment, csp, trail))
 		{
-			auto result = backtrack(assignment, csp);
+			auto result = backtrack(assignment, csp, trail);
 			if (result != nullptr)
 			{
 				return result;
 			}
 		}
-        assignment = old_assignment;
+		variable->clear();
+		trail.undo(mark);
     }
     return nullptr;
 }
@@ -124,56 +346,43 @@ Cnft_variable<K, T>& MRV_select_policy::next(Cnft_assignment<K, T>& assignment)
 			assignment.end(),
 			[](const auto& e1, const auto& e2)
 			{
-				if (e1.second.set())
+				if (e1.set())
 				{
 					return false;
 				}
-				if (e2.second.set())
+				if (e2.set())
 				{
 					return true;
 				}
-				return e1.second.domain().size() < e2.second.domain().size();
+				return e1.domain().size() < e2.domain().size();
 			});
-	return (*it).second;
+	return *it;
 }
 
-template <typename K, typename T>
-std::vector<T> LCV_order_policy::list(Cnft_variable<K, T>& variable,
-		const Cnft_assignment<K, T>& assignment) const
+template <typename K, typename T, typename Relation>
+std::vector<T> LCV_order_policy::list(const Cnft_variable<K, T>& variable,
+		const Cnft_assignment<K, T>& assignment,
+		const Csp<K, T, Relation>& csp) const
 {
 	std::vector<std::pair<unsigned, T>> values_scores;
-	for (const auto& value : get_consistent_domain(variable, assignment))
+	for (const auto& value : get_consistent_domain(variable, assignment, csp))
 	{
-		variable.assign(value);
 		unsigned satisfiable_constraints = 0;
-		for (const auto& other_var_pair : assignment)
+		for (const auto& arc : csp.arcs(variable.index()))
 		{
-			if (other_var_pair.first == variable.id())
+			const auto& other_var = assignment[arc.other];
+			if (other_var.set())
 			{
 				continue;
 			}
-			const auto& other_var = other_var_pair.second;
-			for (const auto& constraint_ref : other_var.constraints())
-			{
-				if (constraint_ref.get().binary())
-				{
-					const auto& constraint = dynamic_cast<const Binary_constraint<K, T>&>(constraint_ref.get());
-					if (constraint.variable_2_id() != variable.id())
-					{
-						continue;
-					}
-					// Check how many values in other_var's domain can cohesist with the current assignment of variable
-					satisfiable_constraints += std::count_if(other_var.domain().cbegin(),
-							other_var.domain().cend(),
-							[&other_var, &constraint, &value](const auto& other_val)
-									{ return constraint.hold(other_val, value); });
-				}
-			}
+			// Check how many values in other_var's domain can cohesist with value
+			satisfiable_constraints += std::count_if(other_var.domain().cbegin(),
+					other_var.domain().cend(),
+					[&csp, &arc, &value](const auto& other_val) { return csp.hold(arc, value, other_val); });
 		}
 		values_scores.push_back(std::make_pair(satisfiable_constraints, value));
-		variable.clear();
 	}
-	std::sort(values_scores.begin(),
+	std::stable_sort(values_scores.begin(),
 			values_scores.end(),
 			[](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
 	std::vector<T> result;
@@ -185,81 +394,151 @@ std::vector<T> LCV_order_policy::list(Cnft_variable<K, T>& variable,
 	return result;
 }
 
-template <typename K, typename T>
+template <typename K, typename T, typename Relation>
 std::vector<T> First_order_policy::list(const Cnft_variable<K, T>& variable,
-		const Cnft_assignment<K, T>& assignment) const
+		const Cnft_assignment<K, T>& assignment,
+		const Csp<K, T, Relation>& csp) const
 {
-	return get_consistent_domain(variable, assignment);
+	return get_consistent_domain(variable, assignment, csp);
 }
 
-template <typename K, typename T>
-bool AC3_consistency::revise(const Cnft_variable<K, T>& variable, Cnft_assignment<K, T>& assignment) const
+template <typename K, typename T, typename Relation>
+bool AC3_consistency::revise(const Cnft_variable<K, T>& variable,
+		Cnft_assignment<K, T>& assignment,
+		const Csp<K, T, Relation>& csp,
+		Domain_trail<T>& trail) const
 {
-	typedef std::reference_wrapper<const Binary_constraint<K, T>> Arc;
-	std::queue<Arc> queue;
-	for (const auto& constraint : variable.constraints())
-	{
-		if (constraint.get().binary())
-		{
-			queue.push(std::cref(dynamic_cast<const Binary_constraint<K, T>&>(constraint.get())));
-		}
-	}
-	while (!queue.empty())
+	typedef typename Csp<K, T, Relation>::Arc Arc;
+	const std::size_t none = static_cast<std::size_t>(-1);
+	std::queue<Revision<K, T, Relation>> queue;
+	std::vector<std::size_t> groups;
+	std::vector<unsigned char> queued_groups(csp.all_different_constraints().size(), 0);
+	// Arcs from every neighbour of changed to changed, and all-different constraints of changed
+	auto push = [&queue, &groups, &queued_groups, &csp](std::size_t changed, std::size_t skip_constraint,
+			std::size_t skip_group)
+			{
+				for (const auto& arc : csp.arcs(changed))
+				{
+					if (arc.constraint != skip_constraint)
+					{
+						queue.push(Revision<K, T, Relation>{arc.other, Arc{changed, arc.constraint, !arc.first}});
+					}
+				}
+				for (std::size_t group : csp.groups(changed))
+				{
+					if (group != skip_group && !queued_groups[group])
+					{
+						queued_groups[group] = 1;
+						groups.push_back(group);
+					}
+				}
+			};
+	push(variable.index(), none, none);
+	detail::Value_graph graph;
+	std::vector<std::size_t> changed;
+	// The binary constraints are cheaper, so they're revised first
+	while (!queue.empty() || !groups.empty())
 	{
-		auto arc = queue.front();
-		queue.pop();
-		if (revise(arc.get(), assignment))
+		if (!queue.empty())
 		{
-			if (variable.domain().empty())
-			{
-				return false;
-			}
-			for (const auto& constraint : variable.constraints())
+			const auto revision = queue.front();
+			queue.pop();
+			if (revise(revision, assignment, csp, trail))
 			{
-				if (&constraint.get() != &arc.get())
+				if (assignment[revision.target].domain().empty())
 				{
-					queue.push(std::cref(dynamic_cast<const Binary_constraint<K, T>&>(constraint.get())));
+					return false;
 				}
+				push(revision.target, revision.arc.constraint, none);
 			}
+			continue;
+		}
+		const std::size_t group = groups.back();
+		groups.pop_back();
+		queued_groups[group] = 0;
+		changed.clear();
+		if (!revise_all_different(group, assignment, csp, trail, graph, changed))
+		{
+			return false;
+		}
+		for (std::size_t index : changed)
+		{
+			push(index, none, group);
 		}
 	}
 	return true;
 }
 
-template <typename K, typename T>
-bool AC3_consistency::revise(const Binary_constraint<K, T>& constraint, Cnft_assignment<K, T>& assignment) const
+template <typename K, typename T, typename Relation>
+bool AC3_consistency::revise(const Revision<K, T, Relation>& revision,
+		Cnft_assignment<K, T>& assignment,
+		const Csp<K, T, Relation>& csp,
+		Domain_trail<T>& trail) const
 {
 	bool revised = false;
+	auto& domain = assignment[revision.target].domain();
+	const auto& support = assignment[revision.arc.other].domain();
+	for (auto it = domain.cbegin(); it != domain.cend(); )
+	{
+		const auto value_it = std::find_if(support.cbegin(),
+				support.cend(),
+				[&csp, &revision, &it](const auto& value) { return csp.hold(revision.arc, *it, value); });
+		const auto position = (it++).position();
+		if (value_it == support.cend())
+		{
+			trail.erase(domain, position);
+			revised = true;
+		}
+	}
+	return revised;
+}
 
-	auto it = assignment.find(constraint.variable_1_id());
-	if (it == assignment.cend())
+template <typename K, typename T, typename Relation>
+bool AC3_consistency::revise_all_different(std::size_t group,
+		Cnft_assignment<K, T>& assignment,
+		const Csp<K, T, Relation>& csp,
+		Domain_trail<T>& trail,
+		detail::Value_graph& graph,
+		std::vector<std::size_t>& changed) const
+{
+	const auto members = csp.members(group);
+	graph.reset(members.size(), csp.group_values(group));
+	std::size_t i = 0;
+	for (const auto& member : members)
 	{
-		throw std::out_of_range("constraint is pointing to inexistant variable");
+		const auto& domain = assignment[member.variable].domain();
+		for (auto it = domain.cbegin(); it != domain.cend(); ++it)
+		{
+			graph.add_edge(i, csp.value_id(member, it.position()));
+		}
+		++i;
 	}
-	auto& var_1 = *it;
-	it = assignment.find(constraint.variable_2_id());
-	if (it == assignment.cend())
+	if (!graph.match())
 	{
-		throw std::out_of_range("constraint is pointing to inexistant variable");
+		return false;
 	}
-	auto& var_2 = *it;
-
-	for (auto it = var_1.second.domain().cbegin(); it != var_1.second.domain().cend(); ++it)
+	graph.filter();
+	i = 0;
+	for (const auto& member : members)
 	{
-		auto value_it = std::find_if(var_2.second.domain().cbegin(),
-				var_2.second.domain().cend(),
-				[it, &constraint](const auto& value) { return constraint.hold(*it, value); });
-		if (value_it == var_2.second.domain().cend())
+		auto& domain = assignment[member.variable].domain();
+		bool revised = false;
+		for (auto it = domain.cbegin(); it != domain.cend(); )
 		{
-			it = var_1.second.domain().erase(it, it + 1);
-			revised = true;
-			if (it == var_1.second.domain().cend())
+			const auto position = (it++).position();
+			if (!graph.consistent(i, csp.value_id(member, position)))
 			{
-				break;
+				trail.erase(domain, position);
+				revised = true;
 			}
 		}
+		if (revised)
+		{
+			changed.push_back(member.variable);
+		}
+		++i;
 	}
-	return revised;
+	return true;
 }
 
 #endif
@@ -8,42 +8,84 @@
 #include <functional>
 #include <unordered_map>
 #include <iterator>
+#include <numeric>
 #include <stdexcept>
+#include <cstddef>
+#include <cstdint>
 
-template <typename K, typename T> class Constraint;
+template <typename T> class Domain;
+template <typename T> class Domain_trail;
 template <typename K, typename T> class Variable;
 template <typename K, typename T> class Cnft_variable;
 template <typename K, typename T> class Conflict;
+template <typename K, typename T, typename Relation> class Csp;
+template <typename K, typename V> class Dense_assignment;
 
 template <typename K, typename T>
 using Variables = std::vector<Variable<K, T>>;
 template <typename K, typename T>
 using Cnft_variables = std::vector<Cnft_variable<K, T>>;
 
+template <typename K>
+using Key_indices = std::unordered_map<K, std::size_t>;
+
 template <typename K, typename T>
-using Assignment = std::unordered_map<K, Variable<K, T>>;
+using Assignment = Dense_assignment<K, Variable<K, T>>;
 template <typename K, typename T>
-using Cnft_assignment = std::unordered_map<K, Cnft_variable<K, T>>;
+using Cnft_assignment = Dense_assignment<K, Cnft_variable<K, T>>;
 
-template <typename K, typename T>
-using Constraints = std::vector<std::unique_ptr<const Constraint<K, T>>>;
+template <typename K, typename T, typename Relation = std::not_equal_to<T>> class Binary_constraint;
 
-template <typename K, typename T>
-using Constraints_ref = std::vector<std::reference_wrapper<const Constraint<K, T>>>;
+template <typename K, typename T, typename Relation = std::not_equal_to<T>>
+using Constraints = std::vector<Binary_constraint<K, T, Relation>>;
 
-template <typename K, typename T> class Unary_constraint;
-template <typename K, typename T> class Binary_constraint;
+template <typename K> class All_different;
 
-template <typename K, typename T> struct Assignment_dispatcher;
-template <typename Assignment> class Concrete_assignment_dispatcher;
+template <typename K>
+using All_different_constraints = std::vector<All_different<K>>;
 
 namespace detail
 {
+	typedef std::uint64_t Domain_word;
+	constexpr std::size_t domain_word_bits = 64;
+
+	inline unsigned popcount(Domain_word word) noexcept
+	{
+#ifdef __GNUC__
+		return static_cast<unsigned>(__builtin_popcountll(word));
+#else
+		unsigned count = 0;
+		for (; word != 0; word &= word - 1)
+		{
+			++count;
+		}
+		return count;
+#endif
+	}
+
+	/**
+	 * @return The index of the lowest set bit of a non-zero word
+	 */
+	inline unsigned lowest_bit(Domain_word word) noexcept
+	{
+#ifdef __GNUC__
+		return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+		unsigned index = 0;
+		for (; (word & 1) == 0; word >>= 1)
+		{
+			++index;
+		}
+		return index;
+#endif
+	}
+
 	/**
-	 * Construct an assignment from a set of variables
+	 * Construct an assignment from a set of variables, numbered by indices
 	 */
     template <template <typename, typename> class A, typename K, typename T>
-    A<K, T> assignment_from_variables(const Variables<K, T>& variables);
+    A<K, T> assignment_from_variables(const Variables<K, T>& variables,
+    		const std::shared_ptr<const Key_indices<K>>& indices);
 }
 
 /**
@@ -54,49 +96,226 @@ bool is_complete(const T& assignment)
 {
     return assignment.cend() == std::find_if(assignment.cbegin(),
             assignment.cend(),
-            [](const auto& e) { return !e.second.set(); });
+            [](const auto& e) { return !e.set(); });
 }
 
 /**
- * Base class representing a constraint.
- * Can't be inherited from (use unary or binary constraint).
+ * Binary constraint: the values of two variables must satisfy relation(value_1, value_2).
+ * The relation is a type known at compile time, so the solver can inline every check.
  */
-template <typename K, typename T>
-class Constraint
+template <typename K, typename T, typename Relation>
+class Binary_constraint
 {
-	template <typename U, typename Y> friend class Unary_constraint;
-	template <typename U, typename Y> friend class Binary_constraint;
-	Constraint() = default;
+	friend class Csp<K, T, Relation>;
 public:
-    virtual ~Constraint() = default;
-    virtual bool hold(const T&, const Variable<K, T>&, const Assignment_dispatcher<K, T>&) const = 0;
-    virtual bool binary() const = 0;
+	Binary_constraint(const K& variable_1, const K& variable_2, const Relation& relation = Relation())
+	: id_1_(variable_1), id_2_(variable_2), relation_(relation)
+	{}
+	bool hold(const T& value_1, const T& value_2) const { return relation_(value_1, value_2); }
+	const K& variable_1_id() const { return id_1_; }
+	const K& variable_2_id() const { return id_2_; }
+	/**
+	 * Indices of the variables, set when the constraint becomes part of a Csp
+	 */
+	std::size_t variable_1_index() const noexcept { return index_1_; }
+	std::size_t variable_2_index() const noexcept { return index_2_; }
+private:
+	K id_1_;
+	K id_2_;
+	std::size_t index_1_ = 0;
+	std::size_t index_2_ = 0;
+	Relation relation_;
 };
 
 /**
- * Base class for unary constraints
+ * Global constraint: all its variables must have different values
  */
-template <typename K, typename T>
-class Unary_constraint : public Constraint<K, T>
+template <typename K>
+class All_different
 {
+	template <typename CK, typename CT, typename Relation> friend class Csp;
 public:
-	~Unary_constraint() override = default;
-	bool binary() const final { return false; }
+	explicit All_different(std::vector<K> variables) : ids_(std::move(variables)) {}
+	const std::vector<K>& variable_ids() const { return ids_; }
+	/**
+	 * Indices of the variables, set when the constraint becomes part of a Csp
+	 */
+	const std::vector<std::size_t>& variable_indices() const { return indices_; }
+private:
+	std::vector<K> ids_;
+	std::vector<std::size_t> indices_;
 };
 
 /**
- * Base class for binary constraints
+ * Finite domain of a variable: a bitset over the values of the initial domain, which are shared by all the copies.
+ * Values can be removed only through a Domain_trail, which can put them back.
  */
-template <typename K, typename T>
-class Binary_constraint : public Constraint<K, T>
+template <typename T>
+class Domain
 {
+	friend class Domain_trail<T>;
 public:
-	~Binary_constraint() override = default;
-    using Constraint<K, T>::hold;
-	virtual bool hold(const T& value_1, const T& value_2) const = 0;
-	virtual const K& variable_1_id() const = 0;
-	virtual const K& variable_2_id() const = 0;
-	bool binary() const final { return true; }
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const T* pointer;
+		typedef const T& reference;
+		const_iterator(const Domain& domain, std::size_t position) : domain_(&domain), position_(position) {}
+		reference operator*() const { return (*domain_->values_)[position_]; }
+		pointer operator->() const { return &**this; }
+		const_iterator& operator++()
+		{
+			position_ = domain_->next(position_ + 1);
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			auto old = *this;
+			++*this;
+			return old;
+		}
+		/**
+		 * @return The position of the value in the initial domain
+		 */
+		std::size_t position() const noexcept { return position_; }
+		bool operator==(const const_iterator& rhs) const noexcept { return position_ == rhs.position_; }
+		bool operator!=(const const_iterator& rhs) const noexcept { return position_ != rhs.position_; }
+	private:
+		const Domain* domain_;
+		std::size_t position_;
+	};
+	typedef const_iterator iterator;
+	typedef T value_type;
+
+	explicit Domain(const std::vector<T>& values)
+	: values_(std::make_shared<const std::vector<T>>(values)),
+			words_((values.size() + detail::domain_word_bits - 1) / detail::domain_word_bits, ~detail::Domain_word(0)),
+			size_(values.size())
+	{
+		if (values.size() % detail::domain_word_bits != 0)
+		{
+			words_.back() >>= detail::domain_word_bits - values.size() % detail::domain_word_bits;
+		}
+	}
+	std::size_t size() const noexcept { return size_; }
+	bool empty() const noexcept { return size_ == 0; }
+	const_iterator begin() const { return const_iterator(*this, next(0)); }
+	const_iterator end() const { return const_iterator(*this, values_->size()); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	/**
+	 * @return The value at a position of the initial domain, or end() if it was removed or isn't in the initial domain
+	 */
+	const_iterator find(const T& value) const
+	{
+		auto it = std::find(values_->cbegin(), values_->cend(), value);
+		const auto position = static_cast<std::size_t>(it - values_->cbegin());
+		return (it != values_->cend() && contains(position)) ? const_iterator(*this, position) : end();
+	}
+	/**
+	 * @return The values of the initial domain, in the order of their positions
+	 */
+	const std::vector<T>& initial_values() const noexcept { return *values_; }
+	bool contains(std::size_t position) const noexcept
+	{
+		return (words_[position / detail::domain_word_bits] >> (position % detail::domain_word_bits)) & 1;
+	}
+private:
+	/**
+	 * @return The first position from first on which is still in the domain, the size of the initial domain if none
+	 */
+	std::size_t next(std::size_t first) const noexcept
+	{
+		std::size_t word = first / detail::domain_word_bits;
+		if (word >= words_.size())
+		{
+			return values_->size();
+		}
+		detail::Domain_word bits = words_[word] & (~detail::Domain_word(0) << (first % detail::domain_word_bits));
+		while (bits == 0)
+		{
+			if (++word == words_.size())
+			{
+				return values_->size();
+			}
+			bits = words_[word];
+		}
+		return word * detail::domain_word_bits + detail::lowest_bit(bits);
+	}
+
+	std::shared_ptr<const std::vector<T>> values_;
+	std::vector<detail::Domain_word> words_;
+	std::size_t size_;
+};
+
+/**
+ * Records the changes to the domains, so that a search can go back to an earlier state by undoing them
+ * instead of copying all the variables
+ */
+template <typename T>
+class Domain_trail
+{
+public:
+	/**
+	 * @return A mark of the current state, to be passed to undo
+	 */
+	std::size_t mark() const noexcept { return entries_.size(); }
+	/**
+	 * @brief Restores the domains as they were when mark was taken
+	 */
+	void undo(std::size_t mark)
+	{
+		while (entries_.size() > mark)
+		{
+			const Entry& entry = entries_.back();
+			detail::Domain_word& word = entry.domain->words_[entry.word];
+			entry.domain->size_ += detail::popcount(entry.bits) - detail::popcount(word);
+			word = entry.bits;
+			entries_.pop_back();
+		}
+	}
+	/**
+	 * @brief Removes the value at a position of the initial domain
+	 */
+	void erase(Domain<T>& domain, std::size_t position)
+	{
+		detail::Domain_word& word = save(domain, position / detail::domain_word_bits);
+		word &= ~(detail::Domain_word(1) << (position % detail::domain_word_bits));
+		--domain.size_;
+	}
+	/**
+	 * @brief Removes all the values but the one at a position of the initial domain
+	 */
+	void reduce_to(Domain<T>& domain, std::size_t position)
+	{
+		for (std::size_t i = 0; i < domain.words_.size(); ++i)
+		{
+			const detail::Domain_word bits = (i == position / detail::domain_word_bits)
+					? detail::Domain_word(1) << (position % detail::domain_word_bits) : 0;
+			if (domain.words_[i] != bits)
+			{
+				save(domain, i) = bits;
+			}
+		}
+		domain.size_ = 1;
+	}
+private:
+	struct Entry
+	{
+		Domain<T>* domain;
+		std::size_t word;
+		detail::Domain_word bits;
+	};
+	detail::Domain_word& save(Domain<T>& domain, std::size_t word)
+	{
+		entries_.push_back(Entry{&domain, word, domain.words_[word]});
+		return domain.words_[word];
+	}
+
+	std::vector<Entry> entries_;
 };
 
 template <typename K, typename T>
@@ -110,11 +329,12 @@ class Variable
 {
 	template <typename VK, typename VT>
 	friend bool operator==(const Variable<VK, VT>&, const VT&) noexcept;
+	template <typename CK, typename CT, typename Relation> friend class Csp;
 public:
     typedef K key_type;
     typedef T value_type;
-    Variable(const K& id, const std::vector<T>& domain, const Constraints_ref<K, T>& constraints)
-    : id_(id), domain_(domain), constraints_(std::make_shared<const Constraints_ref<K, T>>(constraints))
+    Variable(const K& id, const std::vector<T>& domain)
+    : id_(id), domain_(domain)
     {}
     bool set() const { return set_; }
     void assign(const T& value)
@@ -122,18 +342,26 @@ public:
     	value_ = value;
     	set_ = true;
     }
-    void clear() { set_ = false; }
-    template <typename Assignment>
-    bool consistent(const T& value, const Assignment& assignment) const;
+    void clear()
+    {
+    	value_ = T();
+    	set_ = false;
+    }
     auto& domain() { return domain_; };
     const auto& domain() const { return domain_; };
-    const auto& constraints() const { return *constraints_; }
     const K& id() const { return id_; }
+    /**
+     * @return Position of the variable in its Csp
+     */
+    std::size_t index() const { return index_; }
+    /**
+     * @return The assigned value, T() if the variable isn't set: check set() before relying on it
+     */
     const T& value() const { return value_; }
 private:
     K id_;
-    std::vector<T> domain_;
-    const std::shared_ptr<const Constraints_ref<K, T>> constraints_;
+    std::size_t index_ = 0;
+    Domain<T> domain_;
     bool set_ = false;
     T value_ = T();
 };
@@ -141,8 +369,10 @@ private:
 /**
  * @return The subset of a variable's domain for which each value is consistent with the given assignment
  */
-template <typename K, typename T, typename Assignment>
-auto get_consistent_domain(const Variable<K, T>& variable, const Assignment& assignment);
+template <typename K, typename T, typename Assignment, typename Relation>
+std::vector<T> get_consistent_domain(const Variable<K, T>& variable,
+		const Assignment& assignment,
+		const Csp<K, T, Relation>& csp);
 
 template <typename K, typename T>
 bool operator==(const Variable<K, T>& lhs, const T& rhs) noexcept
@@ -179,90 +409,310 @@ bool operator!=(const Cnft_variable<K, T>& lhs, const T& rhs) noexcept
 	return Cnft_variable<K, T>::Base::operator!=(rhs);
 }
 
+/**
+ * Variables of a csp stored contiguously, in the order of their indices.
+ * Keys are translated to indices only by find and at, through the table of the csp.
+ */
+template <typename K, typename V>
+class Dense_assignment
+{
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef typename std::vector<V>::iterator iterator;
+	typedef typename std::vector<V>::const_iterator const_iterator;
+	Dense_assignment(std::vector<V> variables, std::shared_ptr<const Key_indices<K>> indices)
+	: variables_(std::move(variables)), indices_(std::move(indices))
+	{}
+	std::size_t size() const noexcept { return variables_.size(); }
+	iterator begin() noexcept { return variables_.begin(); }
+	iterator end() noexcept { return variables_.end(); }
+	const_iterator begin() const noexcept { return variables_.cbegin(); }
+	const_iterator end() const noexcept { return variables_.cend(); }
+	const_iterator cbegin() const noexcept { return variables_.cbegin(); }
+	const_iterator cend() const noexcept { return variables_.cend(); }
+	V& operator[](std::size_t index) { return variables_[index]; }
+	const V& operator[](std::size_t index) const { return variables_[index]; }
+	iterator find(const K& key)
+	{
+		auto it = indices_->find(key);
+		return it != indices_->cend() ? variables_.begin() + it->second : variables_.end();
+	}
+	const_iterator find(const K& key) const
+	{
+		auto it = indices_->find(key);
+		return it != indices_->cend() ? variables_.cbegin() + it->second : variables_.cend();
+	}
+	const V& at(const K& key) const
+	{
+		auto it = find(key);
+		if (it == cend())
+		{
+			throw std::out_of_range("assignment has no such variable");
+		}
+		return *it;
+	}
+private:
+	std::vector<V> variables_;
+	std::shared_ptr<const Key_indices<K>> indices_;
+};
+
 /**
  * Class representing the abstraction of a csp problem.
  * It's purpose is only that of storing data for an accurate description of the csp.
+ * The keys of the variables are numbered from 0 in the order of the variables, and the constraints refer
+ * to the variables by these indices. The constraints of every variable are kept in a flat adjacency table.
+ * The values of the variables of an all-different constraint are numbered too: every value appearing in
+ * their initial domains gets an id, shared by the variables of the constraint.
+ *
+ * @tparam Relation type of the relation of the binary constraints
  */
-template <typename K, typename T>
+template <typename K, typename T, typename Relation = std::not_equal_to<T>>
 class Csp
 {
 public:
+	/**
+	 * Constraint seen from one of its variables
+	 */
+	struct Arc
+	{
+		// Index of the other variable
+		std::size_t other;
+		std::size_t constraint;
+		// Whether the variable is the first of the constraint
+		bool first;
+	};
+	/**
+	 * Variable of an all-different constraint
+	 */
+	struct Member
+	{
+		std::size_t variable;
+		// Position in the table of value ids of the first value of the variable's initial domain
+		std::size_t first_value;
+	};
+	template <typename E>
+	struct Range
+	{
+		const E* begin() const noexcept { return first; }
+		const E* end() const noexcept { return last; }
+		std::size_t size() const noexcept { return static_cast<std::size_t>(last - first); }
+		const E* first;
+		const E* last;
+	};
+	/**
+	 * Arcs from a variable to its neighbours
+	 */
+	typedef Range<Arc> Arcs;
+
 	Csp(const Csp&) = delete;
-	Csp(Csp&& rhs) noexcept	: variables_(std::move(rhs.variables_)), constraints_(std::move(rhs.constraints_)) {}
-	Csp(Variables<K, T>&& variables, Constraints<K, T>&& constraints)
-	: variables_(std::move(variables)), constraints_(std::move(constraints))
-	{}
+	Csp(Csp&& rhs) = default;
+	Csp(Variables<K, T>&& variables,
+			Constraints<K, T, Relation>&& constraints,
+			All_different_constraints<K>&& all_different = All_different_constraints<K>())
+	: indices_(index_variables(variables)), variables_(std::move(variables)), constraints_(std::move(constraints)),
+			all_different_(std::move(all_different))
+	{
+		for (auto& constraint : constraints_)
+		{
+			constraint.index_1_ = index(constraint.variable_1_id());
+			constraint.index_2_ = index(constraint.variable_2_id());
+		}
+		for (auto& constraint : all_different_)
+		{
+			constraint.indices_.clear();
+			for (const auto& id : constraint.ids_)
+			{
+				constraint.indices_.push_back(index(id));
+			}
+		}
+		build_arcs();
+		build_groups();
+	}
 	const auto& variables() const { return variables_; }
 	const auto& constraints() const { return constraints_; }
+	const auto& all_different_constraints() const { return all_different_; }
+	/**
+	 * @return The index of the variable with the given key
+	 */
+	std::size_t index(const K& key) const
+	{
+		auto it = indices_->find(key);
+		if (it == indices_->cend())
+		{
+			throw std::out_of_range("constraint is pointing to inexistant variable");
+		}
+		return it->second;
+	}
+	const std::shared_ptr<const Key_indices<K>>& indices() const { return indices_; }
+	Arcs arcs(std::size_t index) const noexcept
+	{
+		return Arcs{arcs_.data() + arc_offsets_[index], arcs_.data() + arc_offsets_[index + 1]};
+	}
+	/**
+	 * @return Whether the constraint of an arc holds when its variable has value and the other one other_value
+	 */
+	bool hold(const Arc& arc, const T& value, const T& other_value) const
+	{
+		const auto& constraint = constraints_[arc.constraint];
+		return arc.first ? constraint.hold(value, other_value) : constraint.hold(other_value, value);
+	}
+	/**
+	 * @return The all-different constraints of a variable
+	 */
+	Range<std::size_t> groups(std::size_t index) const noexcept
+	{
+		return Range<std::size_t>{groups_.data() + group_offsets_[index], groups_.data() + group_offsets_[index + 1]};
+	}
+	/**
+	 * @return The variables of an all-different constraint
+	 */
+	Range<Member> members(std::size_t group) const noexcept
+	{
+		return Range<Member>{members_.data() + member_offsets_[group], members_.data() + member_offsets_[group + 1]};
+	}
+	/**
+	 * @return Number of distinct values in the initial domains of the variables of an all-different constraint
+	 */
+	std::size_t group_values(std::size_t group) const noexcept { return group_values_[group]; }
+	/**
+	 * @return Id of the value at a position of the initial domain of a variable of an all-different constraint
+	 */
+	std::size_t value_id(const Member& member, std::size_t position) const noexcept
+	{
+		return value_ids_[member.first_value + position];
+	}
+	/**
+	 * @return Whether a value of a variable satisfies the constraints with the variables already set
+	 */
+	template <typename Assignment>
+	bool consistent(std::size_t index, const T& value, const Assignment& assignment) const
+	{
+		for (const Arc& arc : arcs(index))
+		{
+			const auto& other = assignment[arc.other];
+			if (other.set() && !hold(arc, value, other.value()))
+			{
+				return false;
+			}
+		}
+		for (std::size_t group : groups(index))
+		{
+			for (const Member& member : members(group))
+			{
+				const auto& other = assignment[member.variable];
+				if (member.variable != index && other.set() && other.value() == value)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
 private:
-    const Variables<K, T> variables_;
-    Constraints<K, T> constraints_;
-};
+	static std::shared_ptr<const Key_indices<K>> index_variables(Variables<K, T>& variables)
+	{
+		auto indices = std::make_shared<Key_indices<K>>();
+		for (std::size_t i = 0; i < variables.size(); ++i)
+		{
+			variables[i].index_ = i;
+			if (!indices->insert(std::make_pair(variables[i].id(), i)).second)
+			{
+				throw std::invalid_argument("csp has two variables with the same key");
+			}
+		}
+		return indices;
+	}
+	void build_arcs()
+	{
+		arc_offsets_.assign(variables_.size() + 1, 0);
+		for (const auto& constraint : constraints_)
+		{
+			++arc_offsets_[constraint.index_1_ + 1];
+			++arc_offsets_[constraint.index_2_ + 1];
+		}
+		std::partial_sum(arc_offsets_.begin(), arc_offsets_.end(), arc_offsets_.begin());
+		arcs_.resize(arc_offsets_.back());
+		std::vector<std::size_t> next(arc_offsets_.begin(), arc_offsets_.end() - 1);
+		for (std::size_t i = 0; i < constraints_.size(); ++i)
+		{
+			arcs_[next[constraints_[i].index_1_]++] = Arc{constraints_[i].index_2_, i, true};
+			arcs_[next[constraints_[i].index_2_]++] = Arc{constraints_[i].index_1_, i, false};
+		}
+	}
 
-template <typename K, typename T>
-template <typename Assignment>
-bool Variable<K, T>::consistent(const T& value, const Assignment& assignment) const
-{
-	for (const auto& constraint : *constraints_)
+	void build_groups()
 	{
-		if (!constraint.get().hold(value, *this, Concrete_assignment_dispatcher<Assignment>(assignment)))
+		group_offsets_.assign(variables_.size() + 1, 0);
+		for (const auto& constraint : all_different_)
+		{
+			for (std::size_t variable : constraint.indices_)
+			{
+				++group_offsets_[variable + 1];
+			}
+		}
+		std::partial_sum(group_offsets_.begin(), group_offsets_.end(), group_offsets_.begin());
+		groups_.resize(group_offsets_.back());
+		std::vector<std::size_t> next(group_offsets_.begin(), group_offsets_.end() - 1);
+		member_offsets_.push_back(0);
+		for (std::size_t group = 0; group < all_different_.size(); ++group)
 		{
-			return false;
+			std::vector<T> values;
+			for (std::size_t variable : all_different_[group].indices_)
+			{
+				groups_[next[variable]++] = group;
+				members_.push_back(Member{variable, value_ids_.size()});
+				for (const auto& value : variables_[variable].domain().initial_values())
+				{
+					const auto it = std::find(values.cbegin(), values.cend(), value);
+					value_ids_.push_back(static_cast<std::size_t>(it - values.cbegin()));
+					if (it == values.cend())
+					{
+						values.push_back(value);
+					}
+				}
+			}
+			member_offsets_.push_back(members_.size());
+			group_values_.push_back(values.size());
 		}
 	}
-	return true;
-}
 
-template <typename K, typename T, typename Assignment>
-auto get_consistent_domain(const Variable<K, T>& variable, const Assignment& assignment)
+	std::shared_ptr<const Key_indices<K>> indices_;
+    Variables<K, T> variables_;
+    Constraints<K, T, Relation> constraints_;
+    All_different_constraints<K> all_different_;
+    std::vector<std::size_t> arc_offsets_;
+    std::vector<Arc> arcs_;
+    // All-different constraints of every variable
+    std::vector<std::size_t> group_offsets_;
+    std::vector<std::size_t> groups_;
+    // Variables of every all-different constraint
+    std::vector<std::size_t> member_offsets_;
+    std::vector<Member> members_;
+    std::vector<std::size_t> value_ids_;
+    std::vector<std::size_t> group_values_;
+};
+
+template <typename K, typename T, typename Assignment, typename Relation>
+std::vector<T> get_consistent_domain(const Variable<K, T>& variable,
+		const Assignment& assignment,
+		const Csp<K, T, Relation>& csp)
 {
 	std::vector<T> subset;
 	std::copy_if(variable.domain().cbegin(),
 			variable.domain().cend(),
 			std::back_inserter(subset),
-			[&variable, &assignment](const auto& e) { return variable.consistent(e, assignment); });
+			[&variable, &assignment, &csp](const auto& e) { return csp.consistent(variable.index(), e, assignment); });
 	return subset;
 }
 
-template <typename K, typename T>
-struct Assignment_dispatcher
-{
-    virtual const T& get_value(const K& key) const = 0;
-    virtual ~Assignment_dispatcher() = default;
-};
-
-template <typename Assignment>
-class Concrete_assignment_dispatcher : public Assignment_dispatcher<typename Assignment::key_type, 
-        typename Assignment::mapped_type::value_type>
-{
-    typedef typename Assignment::key_type key_type;
-    typedef typename Assignment::mapped_type::value_type value_type;
-public:
-    Concrete_assignment_dispatcher(const Assignment& assignment) : assignment_(assignment) {}
-    virtual const value_type& get_value(const key_type& key) const override
-    {
-        auto it = assignment_.find(key);
-        if (it == assignment_.cend())
-        {
-        	throw std::out_of_range("constraint is pointing to inexistant variable");
-        }
-        return (*it).second.value();
-    }
-private:
-    const Assignment& assignment_;
-};
-
 namespace detail
 {
     template <template <typename, typename> class A, typename K, typename T>
-    A<K, T> assignment_from_variables(const Variables<K, T>& variables)
+    A<K, T> assignment_from_variables(const Variables<K, T>& variables,
+    		const std::shared_ptr<const Key_indices<K>>& indices)
     {
-        A<K, T> result;
-        for (const auto& var : variables)
-        {
-            result.insert(std::make_pair(var.id(), typename A<K, T>::value_type::second_type(var)));
-        }
-        return result;
+        return A<K, T>(std::vector<typename A<K, T>::mapped_type>(variables.cbegin(), variables.cend()), indices);
     }
 }
 
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <chrono>
 #include "Sudoku_csp.hpp"
+#include "../Heap_allocations.hpp"
 
 Sudoku_values init_config_easy();
 Sudoku_values init_config_intermediate();
@@ -24,10 +25,12 @@ int main()
 void test(const Sudoku_values& values)
 {
 	Sudoku_csp csp = create_csp(values);
+	const auto allocations_start = heap_allocations();
 	auto start = std::chrono::steady_clock::now();
 	auto result = solver(csp);
-	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
-	std::cout << "Time: " << duration.count() << "ms\n";
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	std::cout << "Time: " << duration.count() << " us, heap allocations: " << heap_allocations() - allocations_start
+			<< "\n";
     if (result == nullptr)
     {
     	std::cout << "No result found!" << std::endl;
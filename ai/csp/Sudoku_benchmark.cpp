@@ -0,0 +1,124 @@
+/**
+	Solves a set of hard sudoku puzzles with the backtracking solver, modelled with pairwise constraints and with
+	all-different constraints, checks the solutions and prints the values assigned during the search and the time
+	per puzzle (the minimum over several repetitions) and in total.
+	Usage: Sudoku_benchmark [repetitions]
+ */
+
+#include "Sudoku_board.hpp"
+#include "Sudoku_csp.hpp"
+#include "Backtracking.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+
+	const char* const puzzles[] = {
+		"4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+		"52...6.........7.13...........4..8..6......5...........418.........3..2...87.....",
+		"6.....8.3.4.7.................5.4.7.3..2.....1.6.......2.....5.....8.6......1....",
+		"48.3............71.2.......7.5....6....2..8.............1.76...3.....4......5....",
+		"....14....3....2...7..........9...3.6.1.............8.2.....1.4....5.6.....7.8...",
+		"85...24..72......9..4.........1.7..23.5...9...4...........8..7..17..........36.4.",
+		"..53.....8......2..7..1.5..4....53...1..7...6..32...8..6.5....9..4....3......97..",
+		"12..4......5.69.1...9...5.........7.7...52.9..3......2.9.6...5.4..9..8.1..3...9.4",
+		"...57..3.1......2.7...234......8...4..7..4...49....6.5.42...3.....7..9....18.....",
+		"7..1523........92....3.....1....47.8.......6............9...5.6.4.9.7...8....6.1.",
+		"1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",
+		"8..........36......7..9.2...5...7.......457.....1...3...1....68..85...1..9....4..",
+	};
+
+	Sudoku_values parse(const std::string& puzzle)
+	{
+		Sudoku_values values;
+		for (unsigned i = 0; i < Sudoku_board::size * Sudoku_board::size; ++i)
+		{
+			if (puzzle[i] >= '1' && puzzle[i] <= '9')
+			{
+				const Pos pos{static_cast<Sudoku_board::value_type>(i / Sudoku_board::size),
+						static_cast<Sudoku_board::value_type>(i % Sudoku_board::size)};
+				values.insert({pos, static_cast<Sudoku_board::value_type>(puzzle[i] - '0')});
+			}
+		}
+		return values;
+	}
+
+	bool check(const Sudoku_board& board, const Sudoku_values& values)
+	{
+		return board.solved() && std::all_of(values.cbegin(), values.cend(), [&board](const auto& e)
+				{
+					return board[e.first.x][e.first.y] == e.second;
+				});
+	}
+
+	struct Result
+	{
+		double microseconds;
+		unsigned long long nodes;
+		bool solved;
+	};
+
+	Result solve(const Sudoku_values& values, Sudoku_model model, unsigned repetitions)
+	{
+		Backtracking_solver<> solver;
+		Result result{0, 0, true};
+		for (unsigned i = 0; i < repetitions; ++i)
+		{
+			const Sudoku_csp csp = create_csp(values, model);
+			const auto start = std::chrono::steady_clock::now();
+			const auto solution = solver(csp);
+			const std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start;
+			result.microseconds = (i == 0) ? duration.count() : std::min(result.microseconds, duration.count());
+			result.nodes = solver.nodes();
+			result.solved = result.solved && solution != nullptr && check(make_board(*solution), values);
+		}
+		return result;
+	}
+
+	void add(Result& total, const Result& result)
+	{
+		total.microseconds += result.microseconds;
+		total.nodes += result.nodes;
+		total.solved = total.solved && result.solved;
+	}
+
+	void print(const Result& result)
+	{
+		std::cout << std::setw(10) << result.nodes << " nodes " << std::setw(9) << result.microseconds << " us"
+				<< (result.solved ? "" : " NOT SOLVED");
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned repetitions = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10;
+	Result pairwise_total{0, 0, true};
+	Result all_different_total{0, 0, true};
+	unsigned index = 0;
+	std::cout << std::fixed << std::setprecision(0) << "            " << std::setw(30) << std::left << "pairwise"
+			<< "   all-different" << std::right << std::endl;
+	for (const char* puzzle : puzzles)
+	{
+		const Sudoku_values values = parse(puzzle);
+		const Result pairwise = solve(values, Sudoku_model::pairwise, repetitions);
+		const Result all_different = solve(values, Sudoku_model::all_different, repetitions);
+		add(pairwise_total, pairwise);
+		add(all_different_total, all_different);
+		std::cout << "Puzzle " << std::setw(2) << ++index << ": ";
+		print(pairwise);
+		std::cout << "   ";
+		print(all_different);
+		std::cout << std::endl;
+	}
+	std::cout << "Total:     ";
+	print(pairwise_total);
+	std::cout << "   ";
+	print(all_different_total);
+	std::cout << std::endl;
+}
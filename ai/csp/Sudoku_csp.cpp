@@ -12,27 +12,21 @@ namespace
 	std::vector<Sudoku_board::value_type> get_domain(Pos pos, const Sudoku_values&);
 }
 
-bool Sudoku_constraint::hold(const Sudoku_board::value_type& value,
-		const Variable<Pos, Sudoku_board::value_type>& variable,
-		const Assignment_dispatcher<Pos, Sudoku_board::value_type>& assignment) const
-{
-	const auto other = (variable.id() == first_) ? second_ : first_;
-	return assignment.get_value(other) != value;
-}
-
-bool Sudoku_constraint::hold(const Sudoku_board::value_type& value_1, const Sudoku_board::value_type& value_2) const
-{
-	return value_1 != value_2;
-}
-
-Sudoku_csp create_csp(const Sudoku_values& starting_values)
+Sudoku_csp create_csp(const Sudoku_values& starting_values, Sudoku_model model)
 {
 	// Initialize the constraints
 	Sudoku_constraints constraints;
-	std::unordered_map<Pos, Sudoku_constraints_ref> constraints_map;
+	All_different_constraints<Pos> all_different;
 	for (const auto& block : get_all_blocks_pos())
 	{
-		constraints_from_block(block, std::back_inserter(constraints), constraints_map);
+		if (model == Sudoku_model::all_different)
+		{
+			all_different.emplace_back(std::vector<Pos>(block.cbegin(), block.cend()));
+		}
+		else
+		{
+			constraints_from_block(block, std::back_inserter(constraints));
+		}
 	}
 
 	// Initialize the variables with full domain
@@ -43,11 +37,11 @@ Sudoku_csp create_csp(const Sudoku_values& starting_values)
 		for (Sudoku_board::value_type j = 0; j < Sudoku_board::size; ++j)
 		{
 			Pos pos{i, j};
-			variables.emplace_back(pos, get_domain(pos, starting_values), constraints_map.at(pos));
+			variables.emplace_back(pos, get_domain(pos, starting_values));
 		}
 	}
 
-	return Sudoku_csp(std::move(variables), std::move(constraints));
+	return Sudoku_csp(std::move(variables), std::move(constraints), std::move(all_different));
 }
 
 namespace
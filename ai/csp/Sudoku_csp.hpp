@@ -6,11 +6,14 @@
 #include <iterator>
 #include <unordered_map>
 #include <functional>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
 #include <utility>
 
 typedef Csp<Pos, Sudoku_board::value_type> Sudoku_csp;
+typedef Binary_constraint<Pos, Sudoku_board::value_type> Sudoku_constraint;
 typedef Constraints<Pos, Sudoku_board::value_type> Sudoku_constraints;
-typedef Constraints_ref<Pos, Sudoku_board::value_type> Sudoku_constraints_ref;
 typedef Variables<Pos, Sudoku_board::value_type> Sudoku_variables;
 typedef std::unordered_map<Pos, Sudoku_board::value_type> Sudoku_values;
 
@@ -19,31 +22,27 @@ namespace detail
 	typedef std::vector<std::pair<Pos, Sudoku_board::value_type>> Values_vector;
 }
 
-class Sudoku_constraint : public Binary_constraint<Pos, Sudoku_board::value_type>
+/**
+ * How the rules are expressed: a binary constraint for every pair of squares of a block,
+ * or an all-different constraint for every block
+ */
+enum class Sudoku_model
 {
-public:
-	Sudoku_constraint(Pos first, Pos second) : first_(first), second_(second) {}
-    bool hold(const Sudoku_board::value_type&,
-    		const Variable<Pos, Sudoku_board::value_type>&,
-			const Assignment_dispatcher<Pos, Sudoku_board::value_type>&) const override;
-	bool hold(const Sudoku_board::value_type& value_1, const Sudoku_board::value_type& value_2) const override;
-	const Pos& variable_1_id() const { return first_; }
-	const Pos& variable_2_id() const { return second_; }
-private:
-    Pos first_;
-    Pos second_;
+	pairwise,
+	all_different
 };
 
-Sudoku_csp create_csp(const Sudoku_values& starting_values = Sudoku_values());
+Sudoku_csp create_csp(const Sudoku_values& starting_values = Sudoku_values(),
+		Sudoku_model model = Sudoku_model::pairwise);
 
 template <typename Assignment>
 Sudoku_board make_board(const Assignment& assignment)
 {
 	Sudoku_board board;
 	detail::Values_vector values;
-	for (const auto& i : assignment)
+	for (const auto& variable : assignment)
 	{
-	    values.push_back({i.first, i.second.value()});
+	    values.push_back({variable.id(), variable.value()});
 	}
 	std::sort(values.begin(), values.end());
 	for (unsigned i = 0; i < Sudoku_board::size * Sudoku_board::size; ++i)
@@ -53,25 +52,18 @@ Sudoku_board make_board(const Assignment& assignment)
 	return board;
 }
 
-template <typename C, typename Bk_inserter, typename M>
-void constraints_from_block(const C& squares, Bk_inserter bk_inserter, M& constraints_map)
+/**
+ * Adds a constraint for every pair of squares of a block
+ */
+template <typename C, typename Bk_inserter>
+void constraints_from_block(const C& squares, Bk_inserter bk_inserter)
 {
-	auto size = squares.size();
-	for (const auto square : squares)
+	for (std::size_t i = 0; i < squares.size(); ++i)
 	{
-		std::size_t i = 1;
-		for (std::size_t j = i; j < size; ++j)
+		for (std::size_t j = i + 1; j < squares.size(); ++j)
 		{
-			if (square != squares[j])
-			{
-				auto ptr = std::make_unique<Sudoku_constraint>(square, squares[j]);
-				typedef typename M::mapped_type::value_type constraint_type;
-				constraints_map[square].push_back(static_cast<constraint_type>(std::cref(*ptr)));
-				constraints_map[squares[j]].push_back(static_cast<constraint_type>(std::cref(*ptr)));
-				bk_inserter = std::move(ptr);
-			}
+			bk_inserter = Sudoku_constraint(squares[i], squares[j]);
 		}
-		++i;
 	}
 }
 
@@ -0,0 +1,95 @@
+/**
+	Compares Thread_pool with floating workers and with workers pinned to CPUs by cache topology, which
+	also makes them steal from their cache neighbours first. The effect shows on machines with several
+	last level caches or NUMA nodes; on a single core pinning only removes migrations.
+	Runs PGA on N-queens and the parallel backtracking search counting the solutions of N-queens.
+	Usage: Affinity_benchmark [number of threads] [repetitions]
+ */
+
+#include "Queens_counter.hpp"
+#include "Cpu_topology.hpp"
+#include "N_queens.hpp"
+#include "GA.hpp"
+#include <iostream>
+#include <chrono>
+#include <set>
+#include <cstdlib>
+
+namespace
+{
+
+	typedef std::chrono::steady_clock Clock;
+
+	void print_topology(const Cpu_topology& topology)
+	{
+		std::set<int> cores, l2s, llcs, nodes, packages;
+		for (const auto& cpu : topology.cpus())
+		{
+			cores.insert(cpu.core);
+			l2s.insert(cpu.l2);
+			llcs.insert(cpu.llc);
+			nodes.insert(cpu.node);
+			packages.insert(cpu.package);
+		}
+		std::cout << "CPUs: " << topology.cpus().size() << ", cores: " << cores.size() << ", L2 caches: " << l2s.size()
+				<< ", last level caches: " << llcs.size() << ", NUMA nodes: " << nodes.size()
+				<< ", packages: " << packages.size() << "\nPlacement of the pinned workers:";
+		for (auto cpu : topology.placement())
+		{
+			std::cout << " " << cpu;
+		}
+		std::cout << "\n";
+	}
+
+	double measure_search(unsigned num_threads, bool pin, unsigned repetitions)
+	{
+		static constexpr unsigned size = 14;
+		Thread_pool pool(num_threads, 1024, pin);
+		double best = 0;
+		for (unsigned i = 0; i < repetitions; ++i)
+		{
+			const auto start = Clock::now();
+			const auto solutions = count_queens_solutions(pool, size).solutions;
+			const std::chrono::duration<double, std::milli> duration = Clock::now() - start;
+			if (solutions != 365596)
+			{
+				std::cout << "Wrong number of solutions: " << solutions << "\n";
+			}
+			best = (i == 0) ? duration.count() : std::min(best, duration.count());
+		}
+		return best;
+	}
+
+	double measure_pga(unsigned num_threads, bool pin, unsigned repetitions)
+	{
+		static constexpr unsigned size = 32;
+		static constexpr unsigned iterations = 50;
+		static constexpr unsigned population_size = 2000;
+		PGA<N_queens<size>, Pop_generator<size>, Energy_evaluation<size>, Mutagen<size>> pga;
+		double best = 0;
+		for (unsigned i = 0; i < repetitions; ++i)
+		{
+			const auto start = Clock::now();
+			pga(iterations, population_size, num_threads, pin);
+			const std::chrono::duration<double, std::milli> duration = Clock::now() - start;
+			best = (i == 0) ? duration.count() : std::min(best, duration.count());
+		}
+		return best;
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned num_threads = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+	const unsigned repetitions = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 5;
+	print_topology(Cpu_topology::detect());
+	std::cout << "Threads: " << num_threads << ", best of " << repetitions << " runs\n";
+	for (bool pin : {false, true})
+	{
+		const char* name = pin ? "pinned" : "floating";
+		std::cout << "Backtracking search, " << name << " workers: " << measure_search(num_threads, pin, repetitions)
+				<< " ms\n";
+		std::cout << "PGA, " << name << " workers: " << measure_pga(num_threads, pin, repetitions) << " ms" << std::endl;
+	}
+}
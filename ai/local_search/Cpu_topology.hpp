@@ -0,0 +1,284 @@
+#ifndef AI_CPU_TOPOLOGY_HPP_
+#define AI_CPU_TOPOLOGY_HPP_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <tuple>
+
+#ifdef __linux__
+#define CPU_TOPOLOGY_USE_SYSFS
+#include <sched.h>
+#endif
+
+/**
+ * @brief Caches and NUMA nodes shared by the CPUs the process can run on
+ *
+ * On Linux the topology is read from /sys, elsewhere every CPU is assumed to be a separate core
+ * of the same package.
+ */
+class Cpu_topology
+{
+public:
+	/**
+	 * Groups are identified by the lowest CPU number in them, -1 stands for unknown
+	 */
+	struct Cpu
+	{
+		unsigned id = 0;
+		int core = -1;
+		int l2 = -1;
+		// Last level cache
+		int llc = -1;
+		int node = -1;
+		int package = -1;
+	};
+
+	Cpu_topology() = default;
+	explicit Cpu_topology(std::vector<Cpu> cpus) : cpus_(std::move(cpus)) {}
+	/**
+	 * @brief Reads the topology of the CPUs in the affinity mask of the calling thread
+	 */
+	static Cpu_topology detect();
+	const std::vector<Cpu>& cpus() const noexcept { return cpus_; }
+	bool empty() const noexcept { return cpus_.empty(); }
+	/**
+	 * @return 0 for the same core (hyper-threads), 1 for a shared L2, 2 for a shared last level cache,
+	 * 3 for the same NUMA node, 4 for the same package, 5 otherwise
+	 */
+	static unsigned distance(const Cpu& lhs, const Cpu& rhs) noexcept;
+	/**
+	 * @brief Orders the CPUs so that consecutive ones share as much cache as possible, using one hardware
+	 * thread of every core before the second hardware thread of any
+	 */
+	std::vector<unsigned> placement() const;
+private:
+	std::vector<Cpu> cpus_;
+};
+
+/**
+ * @brief Binds the calling thread to a CPU
+ *
+ * @return False if the thread couldn't be bound or binding isn't supported
+ */
+inline bool pin_current_thread(unsigned cpu)
+{
+#ifdef CPU_TOPOLOGY_USE_SYSFS
+	if (cpu >= CPU_SETSIZE)
+	{
+		return false;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	// Pid 0 is the calling thread
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+namespace detail
+{
+
+	/**
+	 * Parses a list of CPUs in the format of /sys, e.g. "0-3,8,10-11"
+	 */
+	inline std::vector<unsigned> parse_cpu_list(const std::string& list)
+	{
+		std::vector<unsigned> cpus;
+		std::istringstream is(list);
+		std::string range;
+		while (std::getline(is, range, ','))
+		{
+			unsigned first, last;
+			char dash;
+			std::istringstream range_is(range);
+			if (!(range_is >> first))
+			{
+				continue;
+			}
+			last = (range_is >> dash >> last) ? last : first;
+			for (unsigned cpu = first; cpu <= last; ++cpu)
+			{
+				cpus.push_back(cpu);
+			}
+		}
+		return cpus;
+	}
+
+	inline bool read_line(const std::string& path, std::string& line)
+	{
+		std::ifstream is(path);
+		return is && std::getline(is, line);
+	}
+
+	inline int read_int(const std::string& path, int default_value)
+	{
+		std::string line;
+		return read_line(path, line) && !line.empty() ? std::stoi(line) : default_value;
+	}
+
+	/**
+	 * Lowest CPU in the list read from path, or -1
+	 */
+	inline int first_cpu(const std::string& path)
+	{
+		std::string line;
+		if (!read_line(path, line))
+		{
+			return -1;
+		}
+		const auto cpus = parse_cpu_list(line);
+		return cpus.empty() ? -1 : static_cast<int>(*std::min_element(cpus.begin(), cpus.end()));
+	}
+
+}
+
+inline Cpu_topology Cpu_topology::detect()
+{
+	std::vector<Cpu> cpus;
+#ifdef CPU_TOPOLOGY_USE_SYSFS
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+	{
+		for (unsigned i = 0; i < CPU_SETSIZE; ++i)
+		{
+			if (CPU_ISSET(i, &set))
+			{
+				Cpu cpu;
+				cpu.id = i;
+				cpus.push_back(cpu);
+			}
+		}
+	}
+	const std::string root = "/sys/devices/system/";
+	for (auto& cpu : cpus)
+	{
+		const std::string path = root + "cpu/cpu" + std::to_string(cpu.id) + "/";
+		cpu.core = detail::first_cpu(path + "topology/thread_siblings_list");
+		cpu.package = detail::read_int(path + "topology/physical_package_id", -1);
+		int llc_level = 0;
+		for (unsigned index = 0; ; ++index)
+		{
+			const std::string cache = path + "cache/index" + std::to_string(index) + "/";
+			const int level = detail::read_int(cache + "level", -1);
+			if (level < 0)
+			{
+				break;
+			}
+			std::string type;
+			if (!detail::read_line(cache + "type", type) || type == "Instruction")
+			{
+				continue;
+			}
+			const int group = detail::first_cpu(cache + "shared_cpu_list");
+			if (level == 2)
+			{
+				cpu.l2 = group;
+			}
+			if (level >= llc_level)
+			{
+				llc_level = level;
+				cpu.llc = group;
+			}
+		}
+	}
+	std::string nodes;
+	if (detail::read_line(root + "node/online", nodes))
+	{
+		for (auto node : detail::parse_cpu_list(nodes))
+		{
+			std::string node_cpus;
+			if (!detail::read_line(root + "node/node" + std::to_string(node) + "/cpulist", node_cpus))
+			{
+				continue;
+			}
+			for (auto id : detail::parse_cpu_list(node_cpus))
+			{
+				for (auto& cpu : cpus)
+				{
+					if (cpu.id == id)
+					{
+						cpu.node = static_cast<int>(node);
+					}
+				}
+			}
+		}
+	}
+#endif
+	if (cpus.empty())
+	{
+		for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i)
+		{
+			Cpu cpu;
+			cpu.id = i;
+			cpus.push_back(cpu);
+		}
+	}
+	return Cpu_topology(std::move(cpus));
+}
+
+inline unsigned Cpu_topology::distance(const Cpu& lhs, const Cpu& rhs) noexcept
+{
+	auto shared = [](int lhs_group, int rhs_group) { return lhs_group >= 0 && lhs_group == rhs_group; };
+	if (lhs.id == rhs.id || shared(lhs.core, rhs.core))
+	{
+		return 0;
+	}
+	if (shared(lhs.l2, rhs.l2))
+	{
+		return 1;
+	}
+	if (shared(lhs.llc, rhs.llc))
+	{
+		return 2;
+	}
+	// Unknown nodes and packages mean a single one
+	if (lhs.node == rhs.node)
+	{
+		return 3;
+	}
+	return lhs.package == rhs.package ? 4 : 5;
+}
+
+inline std::vector<unsigned> Cpu_topology::placement() const
+{
+	// Rank of every CPU among the hardware threads of its core
+	std::vector<unsigned> thread_ranks(cpus_.size(), 0);
+	for (std::size_t i = 0; i < cpus_.size(); ++i)
+	{
+		for (std::size_t j = 0; j < i; ++j)
+		{
+			if (cpus_[i].core >= 0 && cpus_[j].core == cpus_[i].core)
+			{
+				++thread_ranks[i];
+			}
+		}
+	}
+	std::vector<std::size_t> order(cpus_.size());
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [this, &thread_ranks](std::size_t lhs, std::size_t rhs)
+			{
+				const Cpu& l = cpus_[lhs];
+				const Cpu& r = cpus_[rhs];
+				return std::make_tuple(thread_ranks[lhs], l.package, l.node, l.llc, l.l2, l.core, l.id) <
+						std::make_tuple(thread_ranks[rhs], r.package, r.node, r.llc, r.l2, r.core, r.id);
+			});
+	std::vector<unsigned> ids;
+	for (auto i : order)
+	{
+		ids.push_back(cpus_[i].id);
+	}
+	return ids;
+}
+
+#endif
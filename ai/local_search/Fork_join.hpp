@@ -0,0 +1,191 @@
+#ifndef AI_FORK_JOIN_HPP_
+#define AI_FORK_JOIN_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <utility>
+#include <cstddef>
+#include "Thread_pool.hpp"
+
+/**
+ * @brief Set of tasks running on a Thread_pool which can be waited for together
+ *
+ * While waiting, the calling thread runs pending tasks of the pool instead of blocking, so a task
+ * can fork other tasks and wait for them without deadlocking the pool or leaving a worker idle.
+ */
+class Task_group
+{
+public:
+	/**
+	 * @param priority priority of all the tasks of the group
+	 */
+	explicit Task_group(Thread_pool& pool, Task_priority priority = Task_priority::normal)
+	: pool_(pool), priority_(priority), pending_(0) {}
+	Task_group(const Task_group&) = delete;
+	Task_group& operator=(const Task_group&) = delete;
+	/**
+	 * Waits for the tasks still running, their exceptions are discarded
+	 */
+	~Task_group()
+	{
+		help_until_done();
+	}
+	template <typename Function>
+	void run(Function f);
+	/**
+	 * @brief Runs pending tasks until all the tasks of the group have finished
+	 *
+	 * @throw the first exception thrown by a task of the group
+	 */
+	void wait();
+private:
+	void help_until_done()
+	{
+		while (pending_.load(std::memory_order_acquire) != 0)
+		{
+			pool_.run_pending_task();
+		}
+	}
+
+	Thread_pool& pool_;
+	const Task_priority priority_;
+	std::atomic<std::size_t> pending_;
+	std::mutex exception_mutex_;
+	std::exception_ptr exception_;
+};
+
+template <typename Function>
+void Task_group::run(Function f)
+{
+	pending_.fetch_add(1, std::memory_order_relaxed);
+	pool_.post([this, f = std::move(f)]() mutable
+			{
+				try
+				{
+					f();
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(exception_mutex_);
+					if (!exception_)
+					{
+						exception_ = std::current_exception();
+					}
+				}
+				pending_.fetch_sub(1, std::memory_order_release);
+			}, priority_);
+}
+
+inline void Task_group::wait()
+{
+	help_until_done();
+	std::lock_guard<std::mutex> lock(exception_mutex_);
+	if (exception_)
+	{
+		std::exception_ptr exception;
+		std::swap(exception, exception_);
+		std::rethrow_exception(exception);
+	}
+}
+
+namespace detail
+{
+
+	template <typename Index, typename Body>
+	void parallel_for_split(Task_group& group, Index first, Index last, Index grain_size, const Body& body)
+	{
+		while (last - first > grain_size)
+		{
+			const Index middle = first + (last - first) / 2;
+			group.run([&group, middle, last, grain_size, &body]()
+					{
+						parallel_for_split(group, middle, last, grain_size, body);
+					});
+			last = middle;
+		}
+		body(first, last);
+	}
+
+}
+
+/**
+ * @brief Calls body(first, last) on subranges of [first, last) in parallel
+ *
+ * The range is split in halves until the subranges contain at most grain_size indices.
+ */
+template <typename Index, typename Body>
+void parallel_for(Thread_pool& pool, Index first, Index last, Index grain_size, const Body& body)
+{
+	if (grain_size < 1)
+	{
+		grain_size = 1;
+	}
+	Task_group group(pool);
+	detail::parallel_for_split(group, first, last, grain_size, body);
+	group.wait();
+}
+
+/**
+ * @brief Reduces [first, last) in parallel
+ *
+ * @param body called as body(first, last, identity) on subranges of at most grain_size indices,
+ * returns the partial result of the subrange
+ * @param reduction combines two partial results, it must be associative
+ */
+template <typename Index, typename T, typename Body, typename Reduction>
+T parallel_reduce(Thread_pool& pool,
+		Index first,
+		Index last,
+		Index grain_size,
+		const T& identity,
+		const Body& body,
+		const Reduction& reduction)
+{
+	if (grain_size < 1)
+	{
+		grain_size = 1;
+	}
+	if (last - first <= grain_size)
+	{
+		return body(first, last, identity);
+	}
+	const Index middle = first + (last - first) / 2;
+	T right = identity;
+	Task_group group(pool);
+	group.run([&]() { right = parallel_reduce(pool, middle, last, grain_size, identity, body, reduction); });
+	T left = parallel_reduce(pool, first, middle, grain_size, identity, body, reduction);
+	group.wait();
+	return reduction(std::move(left), std::move(right));
+}
+
+namespace detail
+{
+
+	template <typename Function>
+	inline void parallel_invoke_run(Task_group&, Function& last)
+	{
+		last();
+	}
+
+	template <typename Function, typename... Functions>
+	inline void parallel_invoke_run(Task_group& group, Function& f, Functions&... fs)
+	{
+		group.run([&f]() { f(); });
+		parallel_invoke_run(group, fs...);
+	}
+
+}
+
+/**
+ * @brief Calls all the functions in parallel and waits for them, the last one runs on the calling thread
+ */
+template <typename... Functions>
+void parallel_invoke(Thread_pool& pool, Functions... fs)
+{
+	Task_group group(pool);
+	detail::parallel_invoke_run(group, fs...);
+	group.wait();
+}
+
+#endif
@@ -4,29 +4,82 @@
 #include <vector>
 #include <utility>
 #include <random>
-#include <chrono>
 #include <cstddef>
-#include <future>
+#include <cstdint>
 #include <functional>
 #include <algorithm>
-#include "Thread_pool.hpp"
+#include <type_traits>
+#include "Fork_join.hpp"
+#include "Selection.hpp"
+#include "Random_streams.hpp"
 
 namespace detail
 {
 
 	constexpr float default_pop_size = 1000;
 
+	/**
+	 * True if the generator can write the child of two individuals into an existing individual, reusing
+	 * its memory: generator(x, y, random_engine, child)
+	 */
+	template <typename Generator, typename T, typename Random_engine, typename = void>
+	struct Has_inplace_crossover : std::false_type {};
+
+	template <typename Generator, typename T, typename Random_engine>
+	struct Has_inplace_crossover<Generator, T, Random_engine, decltype(void(std::declval<Generator&>()(
+			std::declval<const T&>(), std::declval<const T&>(), std::declval<Random_engine&>(), std::declval<T&>())))>
+	: std::true_type {};
+
+	/**
+	 * Stream of the random numbers of a child, so that they don't depend on the thread which creates it.
+	 * Generation 0 is the initial population, the last stream of a generation is used to prepare the selection.
+	 */
+	inline std::uint64_t ga_stream(unsigned generation, std::uint32_t child) noexcept
+	{
+		return (static_cast<std::uint64_t>(generation) << 32) | child;
+	}
+
+	constexpr std::uint32_t generation_stream = 0xFFFFFFFFu;
+
+	template <typename Population>
+	std::size_t best_index(const Population& population, std::size_t first, std::size_t last)
+	{
+		std::size_t best = first;
+		for (std::size_t i = first + 1; i < last; ++i)
+		{
+			if (population[i].second < population[best].second)
+			{
+				best = i;
+			}
+		}
+		return best;
+	}
+
 }
 
 /**
  * @brief Generic genetic algorithm
  *
+ * The population lives in two buffers swapped at every generation, so that the individuals are created
+ * once: a generator which can write a child into an existing individual (see detail::Has_inplace_crossover)
+ * makes the generations free of heap allocations.
+ *
+ * Every child draws its random numbers from its own stream of the engine, identified by the generation and
+ * by its index, so that a seed determines the result of a run (see Random_streams.hpp).
+ *
  * @tparam T type of the individuals
  * @tparam Generator callable returning a random population
  * @tparam Fitness callable returning the estimated fitness of an individual (the lower the better)
  * @tparam Mutagen callable applying a mutation to an individual
+ * @tparam Selection policy choosing the parents (see Selection.hpp)
+ * @tparam Engine random engine constructible from a seed and a stream id
  */
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
+template <typename T,
+		typename Generator,
+		typename Fitness,
+		typename Mutagen,
+		typename Selection = Rank_selection,
+		typename Engine = Philox4x32>
 class GA
 {
 public:
@@ -34,33 +87,87 @@ public:
 			const Fitness& fitness = Fitness(),
 			const Mutagen& mutagen = Mutagen(),
 			float mutation_p = 0.01f,
-			float select_factor = 0.05f)
+			const Selection& selection = Selection())
 	: generator_(generator),
 			fitness_(fitness),
 			mutagen_(mutagen),
-			random_(std::chrono::system_clock::now().time_since_epoch().count(),
-					mutation_p,
-					select_factor)
+			selection_(selection),
+			random_(Engine(), mutation_p),
+			seed_(detail::clock_seed())
 	{}
 	T operator()(unsigned max_iterations, unsigned population_size = detail::default_pop_size);
+	/**
+	 * @brief Sets the seed of the following runs: the same seed gives the same results, whatever the number of threads
+	 */
+	void seed(std::uint64_t value) noexcept
+	{
+		seed_ = value;
+		runs_ = 0;
+	}
+	/**
+	 * @brief Stops the following runs as soon as an individual has a fitness of at most value, 0 by default
+	 */
+	void target(float value) noexcept { target_ = value; }
+	/**
+	 * @return Number of generations of the last run
+	 */
+	unsigned iterations() const noexcept { return iterations_; }
 protected:
 	typedef std::pair<T, float> I;
 	typedef std::vector<I> Population;
 	struct Random
 	{
-		std::mt19937 re;
+		Engine re;
 		std::bernoulli_distribution b_dist;
-		std::geometric_distribution<std::size_t> g_dist;
-		template <typename Seed>
-		Random(const Seed& seed, float b, float g) : re(seed), b_dist(b), g_dist(g) {}
+		Random(const Engine& engine, float b) : re(engine), b_dist(b) {}
 	};
-	I reproduce(const I& x, const I& y, Random& random);
-	const I& random_selection(const Population& pop, Random& random, const I* const exclude = nullptr);
+	/**
+	 * @brief Starts a new run: random_ draws from the stream of the initial population
+	 */
+	void start_run()
+	{
+		run_seed_ = detail::run_seed(seed_, runs_++);
+		random_.re = Engine(run_seed_, detail::ga_stream(0, detail::generation_stream));
+	}
+	Random random(unsigned generation, std::uint32_t child) const
+	{
+		return Random(Engine(run_seed_, detail::ga_stream(generation, child)), random_.b_dist.p());
+	}
+	void generate_population(Population& population, unsigned population_size);
+	/**
+	 * @brief Writes the child of x and y into child
+	 */
+	void reproduce(const I& x, const I& y, Random& random, I& child);
+	/**
+	 * @brief Selects two different parents for a child, with a selection prepared for two picks per child
+	 *
+	 * @param child index of the child in the new population
+	 * @return The indices of the parents
+	 */
+	std::pair<std::size_t, std::size_t> random_selection(const Selection& selection,
+			std::size_t child,
+			std::size_t population_size,
+			Random& random) const;
 	inline void mutate(I& i, Random& random);
 	Generator generator_;
 	Fitness fitness_;
 	Mutagen mutagen_;
+	Selection selection_;
 	Random random_;
+	std::uint64_t seed_;
+	std::uint64_t runs_ = 0;
+	std::uint64_t run_seed_ = 0;
+	float target_ = 0;
+	unsigned iterations_ = 0;
+private:
+	void crossover(const I& x, const I& y, Random& random, I& child, std::true_type)
+	{
+		generator_(x.first, y.first, random.re, child.first);
+	}
+	void crossover(const I& x, const I& y, Random& random, I& child, std::false_type)
+	{
+		child.first = generator_(x.first, y.first, random.re);
+	}
 };
 
 namespace detail
@@ -90,71 +197,92 @@ namespace detail
 
 }
 
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
-T GA<T, Generator, Fitness, Mutagen>::operator()(unsigned max_iterations, unsigned population_size)
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+T GA<T, Generator, Fitness, Mutagen, Selection, Engine>::operator()(unsigned max_iterations, unsigned population_size)
 {
+	start_run();
 	Population population;
-	Population new_population(population_size);
-	for (const auto& e : generator_(population_size, random_.re))
+	generate_population(population, population_size);
+	Population new_population(population.size());
+	I best = population[detail::best_index(population, 0, population.size())];
+	iterations_ = 0;
+	for (unsigned i = 0; i < max_iterations && best.second > target_; ++i)
 	{
-		population.push_back(std::make_pair(std::move(e), 0.0f));
-	}
-	std::unique_ptr<I> best;
-	for (unsigned i = 0; i < max_iterations; ++i)
-	{		
-		std::sort(population.begin(),
-				population.end(),
-				[](const auto& lhs, const auto& rhs){ return lhs.second < rhs.second; });
+		const unsigned generation = i + 1;
+		iterations_ = generation;
+		random_.re = Engine(run_seed_, detail::ga_stream(generation, detail::generation_stream));
+		selection_.prepare(population, 2 * population.size(), random_.re);
 		for (std::size_t i = 0; i < population.size(); ++i)
 		{
-			const auto& x = random_selection(population, random_);
-			const auto& y = random_selection(population, random_, &x);
-			I child = reproduce(x, y, random_);
-			detail::check_update_best(child, best);
-			if (child.second == 0)
+			Random random = this->random(generation, static_cast<std::uint32_t>(i));
+			const auto parents = random_selection(selection_, i, population.size(), random);
+			I& child = new_population[i];
+			reproduce(population[parents.first], population[parents.second], random, child);
+			if (child.second > target_ && random.b_dist(random.re))
 			{
-				return child.first;
+				mutate(child, random);
 			}
-			if (random_.b_dist(random_.re))
+			if (child.second <= target_)
 			{
-				mutate(child, random_);
-				detail::check_update_best(child, best);
-				if (child.second == 0)
-				{
-					return child.first;
-				}
+				return child.first;
 			}
-			new_population[i] = std::move(child);
 		}
 		population.swap(new_population);
+		const auto& generation_best = population[detail::best_index(population, 0, population.size())];
+		if (generation_best.second < best.second)
+		{
+			best = generation_best;
+		}
+	}
+	return best.first;
+}
+
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+void GA<T, Generator, Fitness, Mutagen, Selection, Engine>::generate_population(Population& population, unsigned population_size)
+{
+	population.reserve(population_size);
+	for (auto& e : generator_(population_size, random_.re))
+	{
+		const float fitness = fitness_(e);
+		population.push_back(std::make_pair(std::move(e), fitness));
 	}
-	return best->first;
 }
 
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
-typename GA<T, Generator, Fitness, Mutagen>::I
-GA<T, Generator, Fitness, Mutagen>::reproduce(const I& x, const I& y, Random& random)
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+void GA<T, Generator, Fitness, Mutagen, Selection, Engine>::reproduce(const I& x, const I& y, Random& random, I& child)
 {
-	auto child = std::make_pair(generator_(x.first, y.first, random.re), 0);
+	crossover(x, y, random, child, detail::Has_inplace_crossover<Generator, T, Engine>());
 	child.second = fitness_(child.first);
-	return child;
 }
 
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
-const typename GA<T, Generator, Fitness, Mutagen>::I&
-GA<T, Generator, Fitness, Mutagen>::random_selection(const Population& pop, Random& random, const I* const exclude)
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+std::pair<std::size_t, std::size_t>
+GA<T, Generator, Fitness, Mutagen, Selection, Engine>::random_selection(const Selection& selection,
+		std::size_t child,
+		std::size_t population_size,
+		Random& random) const
 {
-	std::size_t index;
-	do 
+	static constexpr unsigned max_attempts = 16;
+	const std::size_t x = selection(2 * child, random.re);
+	std::size_t y = selection(2 * child + 1, random.re);
+	for (unsigned attempt = 1; y == x && population_size > 1; ++attempt)
 	{
-		index = random.g_dist(random.re);
+		if (attempt < max_attempts)
+		{
+			y = selection(2 * child + 1 + 2 * attempt, random.re);
+		}
+		else
+		{
+			// The selection keeps returning the same individual
+			y = std::uniform_int_distribution<std::size_t>(0, population_size - 2)(random.re);
+			y += (y >= x) ? 1 : 0;
+		}
 	}
-	while (index >= pop.size() || &pop[index] == exclude);
-	return pop[index];
+	return std::make_pair(x, y);
 }
 
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
-void GA<T, Generator, Fitness, Mutagen>::mutate(I& i, Random& random)
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+void GA<T, Generator, Fitness, Mutagen, Selection, Engine>::mutate(I& i, Random& random)
 {
 	mutagen_(i.first, random.re);
 	i.second = fitness_(i.first);
@@ -164,130 +292,147 @@ void GA<T, Generator, Fitness, Mutagen>::mutate(I& i, Random& random)
 /**
  * @brief Parallel generic genetic algorithm
  *
+ * Children are created from the same random streams as in GA, so that with the same seed both find the same
+ * individuals whatever the number of threads.
+ *
  * @tparam T type of the individuals
  * @tparam Generator callable returning a random population
  * @tparam Fitness callable returning the estimated fitness of an individual (the lower the better)
  * @tparam Mutagen callable applying a mutation to an individual
+ * @tparam Selection policy choosing the parents (see Selection.hpp)
+ * @tparam Engine random engine constructible from a seed and a stream id
  */
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
-class PGA : GA<T, Generator, Fitness, Mutagen>
+template <typename T,
+		typename Generator,
+		typename Fitness,
+		typename Mutagen,
+		typename Selection = Rank_selection,
+		typename Engine = Philox4x32>
+class PGA : GA<T, Generator, Fitness, Mutagen, Selection, Engine>
 {
-	typedef GA<T, Generator, Fitness, Mutagen> Base;
+	typedef GA<T, Generator, Fitness, Mutagen, Selection, Engine> Base;
 public:
 	using Base::GA;
+	using Base::seed;
+	using Base::target;
+	using Base::iterations;
+	/**
+	 * @param pin_threads bind the workers of the thread pool to CPUs sharing the same caches
+	 */
 	T operator()(unsigned max_iterations, 
 			unsigned population_size = detail::default_pop_size,
-			unsigned num_threads_hint = std::thread::hardware_concurrency());
+			unsigned num_threads_hint = std::thread::hardware_concurrency(),
+			bool pin_threads = false);
 private:
 	typedef std::pair<T, float> I;
 	typedef std::vector<I> Population;
 	typedef typename Population::size_type Pop_size_type;
 	using typename Base::Random;
-	std::unique_ptr<I> task(const Population& population,
+	/**
+	 * @return The index of the best child of the block
+	 */
+	Pop_size_type task(const Population& population,
 			Population& new_population,
 			Pop_size_type first,
 			Pop_size_type last,
-			Random& random);
+			unsigned generation);
 	static constexpr unsigned min_items_per_thread = 50;
 };
 
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
-T PGA<T, Generator, Fitness, Mutagen>::operator()(unsigned max_iterations,
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+T PGA<T, Generator, Fitness, Mutagen, Selection, Engine>::operator()(unsigned max_iterations,
 		unsigned population_size,
-		unsigned num_threads_hint)
+		unsigned num_threads_hint,
+		bool pin_threads)
 {	
 	const unsigned max_threads = (population_size + min_items_per_thread - 1) / min_items_per_thread;
 	const unsigned num_threads = std::min(num_threads_hint != 0 ? num_threads_hint : 2, max_threads);
 	const unsigned block_size = population_size / num_threads;
-	Thread_pool pool_(num_threads - 1);
-	std::vector<std::future<std::unique_ptr<I>>> futures(num_threads - 1);
-	std::vector<Random> randoms;
-	std::uniform_int_distribution<unsigned> d(0, 1000);
-	for (unsigned i = 0; i < (num_threads - 1); ++i)
-	{
-		randoms.emplace_back(d(this->random_.re) * std::chrono::system_clock::now().time_since_epoch().count(),
-				this->random_.b_dist.p(),
-				this->random_.g_dist.p());
-	}
+	Thread_pool pool_(num_threads - 1, 1024, pin_threads);
+	std::vector<Pop_size_type> block_bests(num_threads - 1);
+	this->start_run();
 	Population population;
-	Population new_population(population_size);
-	std::unique_ptr<I> best;
-	for (const auto& e : this->generator_(population_size, this->random_.re))
+	this->generate_population(population, population_size);
+	Population new_population(population.size());
+	I best = population[detail::best_index(population, 0, population.size())];
+	this->iterations_ = 0;
+	for (unsigned i = 0; i < max_iterations && best.second > this->target_; ++i)
 	{
-		population.push_back(std::make_pair(std::move(e), 0.0f));
-	}
-
-	// Preliminary sort
-	std::sort(population.begin(),
-			population.end(),
-			[](const auto& lhs, const auto& rhs){ return lhs.second < rhs.second; });
-	for (unsigned i = 0; i < max_iterations; ++i)
-	{
-		// Merge
-		for (unsigned i = 0; i < (num_threads - 1); ++i)
-		{				
-			std::inplace_merge(population.begin(), 
-					population.begin() + (i + 1) * block_size,
-					(i < num_threads - 2) ? (population.begin() + (i + 2) * block_size) : population.end(),
-					[](const auto& lhs, const auto& rhs){ return lhs.second < rhs.second; });
-		}		
-		// Run tasks
+		const unsigned generation = i + 1;
+		this->iterations_ = generation;
+		this->random_.re = Engine(this->run_seed_, detail::ga_stream(generation, detail::generation_stream));
+		this->selection_.prepare(population, 2 * population.size(), this->random_.re);
+		auto run_block = [&](unsigned i)
+				{
+					block_bests[i] = task(population,
+							new_population,
+							i * block_size,
+							(i + 1) * block_size,
+							generation);
+				};
+		// Run tasks, small enough to be stored without allocating
+		Task_group group(pool_);
 		for (unsigned i = 0; i < (num_threads - 1); ++i)
 		{
-			futures[i] = pool_.submit(std::bind(&PGA<T, Generator, Fitness, Mutagen>::task,
-					this,
-					std::ref(population),
-					std::ref(new_population),
-					i * block_size,
-					(i + 1) * block_size,
-					std::ref(randoms[i])));
+			group.run([&run_block, i]() { run_block(i); });
 		}
-		auto this_best = task(population,
+		auto best_child = task(population,
 				new_population,
 				(num_threads - 1) * block_size,
 				population_size,
-				this->random_);
-		// Wait for all
-		for (unsigned long i = 0; i < (num_threads - 1); ++i)
+				generation);
+		// Wait for all, running the blocks not yet taken by the pool
+		group.wait();
+		// Ties go to the lowest index, as in GA, so that the result doesn't depend on the blocks
+		for (auto block_best : block_bests)
 		{
-			detail::check_update_best(std::move(futures[i].get()), best);
-		}		
-		detail::check_update_best(std::move(this_best), best);
-		if (best->second == 0)
+			const float fitness = new_population[block_best].second;
+			if (fitness < new_population[best_child].second ||
+					(fitness == new_population[best_child].second && block_best < best_child))
+			{
+				best_child = block_best;
+			}
+		}
+		if (new_population[best_child].second <= this->target_)
+		{
+			// GA stops at the first child reaching the target
+			for (const auto& child : new_population)
+			{
+				if (child.second <= this->target_)
+				{
+					return child.first;
+				}
+			}
+		}
+		if (new_population[best_child].second < best.second)
 		{
-			return best->first;
+			best = new_population[best_child];
 		}
 		population.swap(new_population);
 	}
-	return best->first;	
+	return best.first;	
 }
 
-template <typename T, typename Generator, typename Fitness, typename Mutagen>
-std::unique_ptr<typename PGA<T, Generator, Fitness, Mutagen>::I>
-PGA<T, Generator, Fitness, Mutagen>::task(const Population& population,
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+typename PGA<T, Generator, Fitness, Mutagen, Selection, Engine>::Pop_size_type
+PGA<T, Generator, Fitness, Mutagen, Selection, Engine>::task(const Population& population,
 		Population& new_population,
 		Pop_size_type first,
 		Pop_size_type last,
-		Random& random)
+		unsigned generation)
 {
-	std::unique_ptr<I> best;
 	for (Pop_size_type i = first; i < last; ++i)
 	{
-		const auto& x = this->random_selection(population, random);
-		const auto& y = this->random_selection(population, random, &x);
-		I child = this->reproduce(x, y, random);
-		detail::check_update_best(child, best);
-		if (random.b_dist(random.re))
+		Random random = this->random(generation, static_cast<std::uint32_t>(i));
+		const auto parents = this->random_selection(this->selection_, i, population.size(), random);
+		I& child = new_population[i];
+		this->reproduce(population[parents.first], population[parents.second], random, child);
+		if (child.second > this->target_ && random.b_dist(random.re))
 		{
 			this->mutate(child, random);
-			detail::check_update_best(child, best);
 		}
-		new_population[i] = std::move(child);
 	}
-	std::sort(new_population.begin() + first,
-			new_population.begin() + last,
-			[](const auto& lhs, const auto& rhs){ return lhs.second < rhs.second; });
-	return best;
+	return detail::best_index(new_population, first, last);
 }
 
 #endif
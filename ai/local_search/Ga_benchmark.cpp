@@ -0,0 +1,76 @@
+/**
+	Measures the time and the heap allocations per generation of GA and PGA on the N-queens puzzle,
+	with every selection policy, and the conflicts left in the best individual found.
+	Every algorithm runs twice with a different number of generations, the difference between the two
+	runs excludes the cost of creating the initial population.
+	Usage: Ga_benchmark [generations] [population size] [number of threads]
+ */
+
+#include "N_queens.hpp"
+#include "GA.hpp"
+#include "../Heap_allocations.hpp"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+namespace
+{
+
+	static constexpr unsigned size = 32;
+
+	struct Run
+	{
+		unsigned long allocations;
+		double milliseconds;
+		float conflicts;
+	};
+
+	template <typename Solver, typename... Args>
+	Run run(unsigned generations, Args... args)
+	{
+		Solver solver;
+		const auto allocations_start = heap_allocations();
+		const auto start = std::chrono::steady_clock::now();
+		const auto result = solver(generations, args...);
+		const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+		return Run{heap_allocations() - allocations_start, duration.count(), Energy_evaluation<size>{}(result)};
+	}
+
+	template <typename Solver, typename... Args>
+	void measure(const char* name, unsigned generations, Args... args)
+	{
+		const Run first = run<Solver>(1, args...);
+		const Run second = run<Solver>(generations + 1, args...);
+		std::cout << name << ": " << (second.milliseconds - first.milliseconds) / generations << " ms and "
+				<< static_cast<double>(second.allocations - first.allocations) / generations
+				<< " heap allocations per generation, " << second.conflicts << " conflicts" << std::endl;
+	}
+
+	template <typename Selection>
+	void measure_selection(const char* ga_name,
+			const char* pga_name,
+			unsigned generations,
+			unsigned population_size,
+			unsigned num_threads)
+	{
+		measure<GA<N_queens<size>, Pop_generator<size>, Energy_evaluation<size>, Mutagen<size>, Selection>>(ga_name,
+				generations, population_size);
+		measure<PGA<N_queens<size>, Pop_generator<size>, Energy_evaluation<size>, Mutagen<size>, Selection>>(pga_name,
+				generations, population_size, num_threads);
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned generations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100;
+	const unsigned population_size = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2000;
+	const unsigned num_threads = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : std::thread::hardware_concurrency();
+	std::cout << size << " queens, population: " << population_size << ", threads: " << num_threads << "\n";
+	measure_selection<Rank_selection>("GA, rank", "PGA, rank", generations, population_size, num_threads);
+	measure_selection<Tournament_selection>("GA, tournament", "PGA, tournament",
+			generations, population_size, num_threads);
+	measure_selection<Alias_selection>("GA, roulette", "PGA, roulette", generations, population_size, num_threads);
+	measure_selection<Sus_selection>("GA, SUS", "PGA, SUS", generations, population_size, num_threads);
+}
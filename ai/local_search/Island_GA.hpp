@@ -0,0 +1,204 @@
+#ifndef AI_SEARCHING_ISLAND_GA_HPP_
+#define AI_SEARCHING_ISLAND_GA_HPP_
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include "GA.hpp"
+#include "../../concurrency/Mpmc_queue.hpp"
+
+/**
+ * @brief Island model genetic algorithm
+ *
+ * The population is split into islands evolving independently, each on its own thread. Every few generations
+ * an island sends copies of its best individuals to the next island of a ring through a lock-free mailbox,
+ * where they replace the worst individuals; islands never wait for each other.
+ *
+ * @tparam T type of the individuals
+ * @tparam Generator callable returning a random population
+ * @tparam Fitness callable returning the estimated fitness of an individual (the lower the better)
+ * @tparam Mutagen callable applying a mutation to an individual
+ * @tparam Selection policy choosing the parents (see Selection.hpp)
+ * @tparam Engine random engine constructible from a seed and a stream id; as islands exchange migrants
+ * asynchronously, a seed doesn't determine the result
+ */
+template <typename T,
+		typename Generator,
+		typename Fitness,
+		typename Mutagen,
+		typename Selection = Rank_selection,
+		typename Engine = Philox4x32>
+class Island_GA : GA<T, Generator, Fitness, Mutagen, Selection, Engine>
+{
+	typedef GA<T, Generator, Fitness, Mutagen, Selection, Engine> Base;
+public:
+	using Base::GA;
+	using Base::seed;
+	using Base::target;
+	/**
+	 * @param max_iterations maximum number of generations of every island
+	 * @param migration_interval generations between two migrations
+	 * @param num_migrants number of individuals sent at every migration
+	 * @throw std::invalid_argument if the population is empty or the migration interval is zero
+	 */
+	T operator()(unsigned max_iterations,
+			unsigned population_size = detail::default_pop_size,
+			unsigned num_islands_hint = std::thread::hardware_concurrency(),
+			unsigned migration_interval = 10,
+			unsigned num_migrants = 2);
+private:
+	typedef std::pair<T, float> I;
+	typedef std::vector<I> Population;
+	using typename Base::Random;
+	struct Island
+	{
+		Island(Random random, const Selection& selection, std::size_t mailbox_capacity)
+		: random(std::move(random)), selection(selection), mailbox(mailbox_capacity) {}
+		Population population;
+		Population new_population;
+		Random random;
+		Selection selection;
+		std::unique_ptr<I> best;
+		// (fitness, index) keys of the population, ordered just enough to find the emigrants and the slots
+		// of the immigrants
+		std::vector<std::pair<float, std::size_t>> keys;
+		// Migrants sent by the previous island
+		Mpmc_queue<I> mailbox;
+	};
+	void evolve(Island& island,
+			Island& next,
+			unsigned max_iterations,
+			unsigned migration_interval,
+			unsigned num_migrants,
+			std::atomic<bool>& solved);
+	static constexpr unsigned min_island_size = 50;
+};
+
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+T Island_GA<T, Generator, Fitness, Mutagen, Selection, Engine>::operator()(unsigned max_iterations,
+		unsigned population_size,
+		unsigned num_islands_hint,
+		unsigned migration_interval,
+		unsigned num_migrants)
+{
+	if (population_size == 0)
+	{
+		throw std::invalid_argument("Island_GA needs a population of at least one individual");
+	}
+	if (migration_interval == 0)
+	{
+		throw std::invalid_argument("Island_GA needs a migration interval of at least one generation");
+	}
+	const unsigned max_islands = std::max(1u, population_size / min_island_size);
+	const unsigned num_islands = std::min(num_islands_hint != 0 ? num_islands_hint : 2, max_islands);
+	this->start_run();
+	std::vector<std::unique_ptr<Island>> islands;
+	for (unsigned i = 0; i < num_islands; ++i)
+	{
+		// Every island draws from the stream of a child of the initial population
+		islands.push_back(std::make_unique<Island>(this->random(0, i), this->selection_, std::max(2u, 4 * num_migrants)));
+	}
+	std::size_t index = 0;
+	for (auto& e : this->generator_(population_size, this->random_.re))
+	{
+		islands[index++ * num_islands / population_size]->population.push_back(std::make_pair(std::move(e), 0.0f));
+	}
+
+	std::atomic<bool> solved(false);
+	{
+		Thread_pool pool(num_islands - 1);
+		Task_group group(pool);
+		for (unsigned i = 1; i < num_islands; ++i)
+		{
+			group.run([&, i]()
+					{
+						evolve(*islands[i], *islands[(i + 1) % num_islands], max_iterations,
+								migration_interval, num_migrants, solved);
+					});
+		}
+		evolve(*islands[0], *islands[1 % num_islands], max_iterations, migration_interval, num_migrants, solved);
+		group.wait();
+	}
+	std::unique_ptr<I> best;
+	for (auto& island : islands)
+	{
+		detail::check_update_best(std::move(island->best), best);
+	}
+	return best->first;
+}
+
+template <typename T, typename Generator, typename Fitness, typename Mutagen, typename Selection, typename Engine>
+void Island_GA<T, Generator, Fitness, Mutagen, Selection, Engine>::evolve(Island& island,
+		Island& next,
+		unsigned max_iterations,
+		unsigned migration_interval,
+		unsigned num_migrants,
+		std::atomic<bool>& solved)
+{
+	Population& population = island.population;
+	Random& random = island.random;
+	auto& keys = island.keys;
+	for (auto& individual : population)
+	{
+		individual.second = this->fitness_(individual.first);
+		detail::check_update_best(individual, island.best);
+	}
+	island.new_population.resize(population.size());
+	keys.resize(population.size());
+	for (unsigned generation = 0; generation < max_iterations; ++generation)
+	{
+		if (island.best->second <= this->target_)
+		{
+			solved.store(true, std::memory_order_relaxed);
+			return;
+		}
+		if (solved.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+		for (std::size_t i = 0; i < population.size(); ++i)
+		{
+			keys[i] = std::make_pair(population[i].second, i);
+		}
+		if (generation != 0 && generation % migration_interval == 0)
+		{
+			const auto num_emigrants = std::min<std::size_t>(num_migrants, keys.size());
+			std::partial_sort(keys.begin(), keys.begin() + num_emigrants, keys.end());
+			// A full mailbox means the next island is behind, its pending migrants are enough
+			for (std::size_t i = 0; i < num_emigrants; ++i)
+			{
+				next.mailbox.try_push(I(population[keys[i].second]));
+			}
+		}
+		// Immigrants replace the worst individuals, there can't be more of them than the mailbox holds
+		const auto first_worst = keys.end() - std::min(island.mailbox.capacity(), keys.size());
+		std::nth_element(keys.begin(), first_worst, keys.end());
+		std::sort(first_worst, keys.end(), std::greater<>());
+		auto slot = first_worst;
+		while (slot != keys.end() && island.mailbox.try_pop(population[slot->second]))
+		{
+			++slot;
+		}
+		island.selection.prepare(population, 2 * population.size(), random.re);
+		for (std::size_t i = 0; i < population.size(); ++i)
+		{
+			const auto parents = this->random_selection(island.selection, i, population.size(), random);
+			I& child = island.new_population[i];
+			this->reproduce(population[parents.first], population[parents.second], random, child);
+			if (random.b_dist(random.re))
+			{
+				this->mutate(child, random);
+			}
+			detail::check_update_best(child, island.best);
+		}
+		population.swap(island.new_population);
+	}
+}
+
+#endif
@@ -0,0 +1,69 @@
+/**
+	Compares PGA, which synchronizes all its threads at every generation, with Island_GA, whose islands
+	evolve independently and only exchange migrants through mailboxes, on N-queens boards of growing size.
+	Both run for the same number of generations on a population of the same size.
+	Usage: Island_benchmark [generations] [population size] [number of threads] [repetitions]
+ */
+
+#include "N_queens.hpp"
+#include "GA.hpp"
+#include "Island_GA.hpp"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+namespace
+{
+
+	struct Settings
+	{
+		unsigned generations;
+		unsigned population_size;
+		unsigned num_threads;
+		unsigned repetitions;
+	};
+
+	template <typename Solver, unsigned N>
+	void measure(const char* name, const Settings& settings)
+	{
+		double total_time = 0;
+		double total_fitness = 0;
+		unsigned solved = 0;
+		for (unsigned i = 0; i < settings.repetitions; ++i)
+		{
+			Solver solver;
+			const auto start = std::chrono::steady_clock::now();
+			const auto result = solver(settings.generations, settings.population_size, settings.num_threads);
+			const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+			const float fitness = Energy_evaluation<N>{}(result);
+			total_time += duration.count();
+			total_fitness += fitness;
+			solved += (fitness == 0) ? 1 : 0;
+		}
+		std::cout << "N = " << N << ", " << name << ": " << total_time / settings.repetitions << " ms, conflicts of the best "
+				<< total_fitness / settings.repetitions << ", solved " << solved << "/" << settings.repetitions << std::endl;
+	}
+
+	template <unsigned N>
+	void compare(const Settings& settings)
+	{
+		measure<PGA<N_queens<N>, Pop_generator<N>, Energy_evaluation<N>, Mutagen<N>>, N>("PGA", settings);
+		measure<Island_GA<N_queens<N>, Pop_generator<N>, Energy_evaluation<N>, Mutagen<N>>, N>("Island_GA", settings);
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	Settings settings;
+	settings.generations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100;
+	settings.population_size = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2000;
+	settings.num_threads = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : std::thread::hardware_concurrency();
+	settings.repetitions = (argc > 4) ? std::strtoul(argv[4], nullptr, 10) : 3;
+	std::cout << "Generations: " << settings.generations << ", population: " << settings.population_size
+			<< ", threads: " << settings.num_threads << "\n";
+	compare<16>(settings);
+	compare<32>(settings);
+	compare<64>(settings);
+}
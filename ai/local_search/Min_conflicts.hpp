@@ -0,0 +1,222 @@
+#ifndef AI_SEARCHING_MIN_CONFLICTS_HPP_
+#define AI_SEARCHING_MIN_CONFLICTS_HPP_
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @brief Min-conflicts local search for the N-queens puzzle, with N chosen at runtime
+ *
+ * The queens are a permutation of the rows, one queen per column and per row, so only diagonals can be
+ * attacked. The first queens are placed greedily on free rows that no placed queen attacks, the last ones
+ * at random. Then every step picks a conflicted queen and swaps its row with the partner leaving the fewest
+ * conflicts among a few queens sampled at random, unless all the sampled swaps increase the conflicts; the
+ * search restarts if it takes too long. Sampling keeps the steps cheap on large boards, where trying every
+ * partner would take linear time. The queens on every diagonal are counted, so evaluating a swap takes
+ * constant time, and the conflicted queens are kept in a candidate list, so that the search never scans
+ * the board.
+ */
+class Min_conflicts_queens
+{
+public:
+	/**
+	 * @param samples swap partners sampled at every step
+	 */
+	explicit Min_conflicts_queens(unsigned seed = std::chrono::system_clock::now().time_since_epoch().count(),
+			unsigned samples = 8)
+	: re_(seed), samples_(std::max(1u, samples))
+	{}
+	/**
+	 * @param steps_per_queen steps for every queen before restarting from a new placement
+	 * @return Row of the queen of every column, a solution unless max_restarts is reached
+	 */
+	std::vector<unsigned> operator()(unsigned n,
+			unsigned steps_per_queen = 50,
+			unsigned max_restarts = 1000);
+	/**
+	 * @return Conflicts left by the last run, 0 if it found a solution
+	 */
+	unsigned conflicts() const noexcept { return conflicts_; }
+	/**
+	 * @return Steps of the last run, across restarts
+	 */
+	unsigned long long steps() const noexcept { return steps_; }
+	unsigned restarts() const noexcept { return restarts_; }
+private:
+	// Queens placed at random after the greedy placement, too few free rows are left for it to be fast
+	static constexpr unsigned random_tail = 50;
+	static constexpr unsigned greedy_attempts = 100;
+
+	std::uint32_t& diagonal(unsigned column, unsigned row) noexcept { return diagonals_[row + column]; }
+	std::uint32_t& antidiagonal(unsigned column, unsigned row) noexcept { return antidiagonals_[row + n_ - 1 - column]; }
+	void add_queen(unsigned column) noexcept
+	{
+		conflicts_ += (diagonal(column, rows_[column])++ != 0) ? 1 : 0;
+		conflicts_ += (antidiagonal(column, rows_[column])++ != 0) ? 1 : 0;
+	}
+	void remove_queen(unsigned column) noexcept
+	{
+		conflicts_ -= (--diagonal(column, rows_[column]) != 0) ? 1 : 0;
+		conflicts_ -= (--antidiagonal(column, rows_[column]) != 0) ? 1 : 0;
+	}
+	bool attacked(unsigned column) noexcept
+	{
+		return diagonal(column, rows_[column]) > 1 || antidiagonal(column, rows_[column]) > 1;
+	}
+	void swap_rows(unsigned lhs, unsigned rhs) noexcept
+	{
+		remove_queen(lhs);
+		remove_queen(rhs);
+		std::swap(rows_[lhs], rows_[rhs]);
+		add_queen(lhs);
+		add_queen(rhs);
+	}
+	void place();
+	void add_candidate(unsigned column);
+	bool repair(unsigned long long max_steps);
+
+	std::mt19937 re_;
+	unsigned samples_;
+	unsigned n_ = 0;
+	std::vector<unsigned> rows_;
+	std::vector<std::uint32_t> diagonals_;
+	std::vector<std::uint32_t> antidiagonals_;
+	// Conflicted queens, possibly with some which aren't conflicted anymore, and their position in the list
+	std::vector<unsigned> candidates_;
+	std::vector<unsigned> candidate_index_;
+	unsigned conflicts_ = 0;
+	unsigned long long steps_ = 0;
+	unsigned restarts_ = 0;
+};
+
+/**
+ * @return Pairs of attacking queens in a placement with one queen per column, counted in linear time
+ */
+inline unsigned long long count_attacks(const std::vector<unsigned>& rows)
+{
+	const std::size_t n = rows.size();
+	std::vector<std::uint32_t> row_count(n, 0);
+	std::vector<std::uint32_t> diagonals(2 * n, 0);
+	std::vector<std::uint32_t> antidiagonals(2 * n, 0);
+	unsigned long long attacks = 0;
+	for (std::size_t column = 0; column < n; ++column)
+	{
+		attacks += row_count[rows[column]]++;
+		attacks += diagonals[rows[column] + column]++;
+		attacks += antidiagonals[rows[column] + n - 1 - column]++;
+	}
+	return attacks;
+}
+
+inline std::vector<unsigned> Min_conflicts_queens::operator()(unsigned n,
+		unsigned steps_per_queen,
+		unsigned max_restarts)
+{
+	n_ = n;
+	steps_ = 0;
+	restarts_ = 0;
+	conflicts_ = 0;
+	if (n == 0)
+	{
+		return {};
+	}
+	// Small boards need a few hundred steps even if they have few queens
+	const unsigned long long max_steps = static_cast<unsigned long long>(steps_per_queen) * (n + 20);
+	for (restarts_ = 0; ; ++restarts_)
+	{
+		place();
+		if (repair(max_steps) || restarts_ == max_restarts)
+		{
+			return rows_;
+		}
+	}
+}
+
+inline void Min_conflicts_queens::place()
+{
+	rows_.resize(n_);
+	for (unsigned column = 0; column < n_; ++column)
+	{
+		rows_[column] = column;
+	}
+	diagonals_.assign(2 * n_, 0);
+	antidiagonals_.assign(2 * n_, 0);
+	conflicts_ = 0;
+	// Column i picks its row among the rows still free, which are the ones of columns i to n-1
+	const unsigned greedy = n_ > random_tail ? n_ - random_tail : 0;
+	for (unsigned column = 0; column < n_; ++column)
+	{
+		std::uniform_int_distribution<unsigned> d(column, n_ - 1);
+		const unsigned attempts = column < greedy ? greedy_attempts : 1;
+		for (unsigned i = 0; i < attempts; ++i)
+		{
+			std::swap(rows_[column], rows_[d(re_)]);
+			if (diagonal(column, rows_[column]) == 0 && antidiagonal(column, rows_[column]) == 0)
+			{
+				break;
+			}
+		}
+		add_queen(column);
+	}
+	candidates_.clear();
+	candidate_index_.assign(n_, n_);
+	for (unsigned column = 0; column < n_; ++column)
+	{
+		add_candidate(column);
+	}
+}
+
+inline void Min_conflicts_queens::add_candidate(unsigned column)
+{
+	if (candidate_index_[column] == n_ && attacked(column))
+	{
+		candidate_index_[column] = static_cast<unsigned>(candidates_.size());
+		candidates_.push_back(column);
+	}
+}
+
+inline bool Min_conflicts_queens::repair(unsigned long long max_steps)
+{
+	std::uniform_int_distribution<unsigned> any_column(0, n_ - 1);
+	for (unsigned long long step = 0; step < max_steps && conflicts_ != 0; ++step, ++steps_)
+	{
+		const unsigned index = std::uniform_int_distribution<std::size_t>(0, candidates_.size() - 1)(re_);
+		const unsigned column = candidates_[index];
+		if (!attacked(column))
+		{
+			candidate_index_[candidates_.back()] = index;
+			candidates_[index] = candidates_.back();
+			candidates_.pop_back();
+			candidate_index_[column] = n_;
+			continue;
+		}
+		// Sideways swaps let the search cross plateaus, so the best partner may leave the conflicts unchanged
+		unsigned best = column;
+		unsigned best_conflicts = conflicts_;
+		for (unsigned i = 0; i < samples_; ++i)
+		{
+			const unsigned other = any_column(re_);
+			swap_rows(column, other);
+			if (conflicts_ < best_conflicts || (conflicts_ == best_conflicts && best == column))
+			{
+				best = other;
+				best_conflicts = conflicts_;
+			}
+			swap_rows(column, other);
+		}
+		if (best != column)
+		{
+			swap_rows(column, best);
+			// Only the moved queens can bring a second queen on a line, so every conflicted line keeps a candidate
+			add_candidate(column);
+			add_candidate(best);
+		}
+	}
+	return conflicts_ == 0;
+}
+
+#endif
@@ -0,0 +1,102 @@
+/**
+	Compares the bounded lock-free Mpmc_queue with the two-lock linked list Threadsafe_queue.
+	Producers push a fixed number of values which consumers pop until all of them have been received,
+	first with one producer and several consumers, then with the same number of producers and consumers.
+	Usage: Mpmc_queue_benchmark [number of values] [number of consumers] [capacity of Mpmc_queue]
+ */
+
+#include "../../concurrency/Mpmc_queue.hpp"
+#include "Thread_pool.hpp"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+
+	struct Threadsafe_adapter
+	{
+		explicit Threadsafe_adapter(std::size_t) {}
+		void push(std::uint64_t value) { queue.push(value); }
+		bool try_pop(std::uint64_t& value) { return queue.try_pop(value); }
+		Threadsafe_queue<std::uint64_t> queue;
+	};
+
+	struct Mpmc_adapter
+	{
+		explicit Mpmc_adapter(std::size_t capacity) : queue(capacity) {}
+		void push(std::uint64_t value) { queue.push(value); }
+		bool try_pop(std::uint64_t& value) { return queue.try_pop(value); }
+		Mpmc_queue<std::uint64_t> queue;
+	};
+
+	template <typename Queue>
+	void run(const char* name,
+			std::size_t capacity,
+			unsigned num_producers,
+			unsigned num_consumers,
+			std::uint64_t num_values)
+	{
+		Queue queue(capacity);
+		std::atomic<std::uint64_t> received(0);
+		std::atomic<std::uint64_t> sum(0);
+		std::vector<std::thread> threads;
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < num_producers; ++i)
+		{
+			threads.emplace_back([&queue, i, num_producers, num_values]()
+					{
+						for (std::uint64_t value = i; value < num_values; value += num_producers)
+						{
+							queue.push(value);
+						}
+					});
+		}
+		for (unsigned i = 0; i < num_consumers; ++i)
+		{
+			threads.emplace_back([&queue, &received, &sum, num_values]()
+					{
+						std::uint64_t local_sum = 0;
+						std::uint64_t value;
+						while (received.load(std::memory_order_relaxed) < num_values)
+						{
+							if (queue.try_pop(value))
+							{
+								local_sum += value;
+								received.fetch_add(1, std::memory_order_relaxed);
+							}
+							else
+							{
+								std::this_thread::yield();
+							}
+						}
+						sum.fetch_add(local_sum);
+					});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		const bool correct = sum.load() == num_values * (num_values - 1) / 2;
+		std::cout << name << ", " << num_producers << " to " << num_consumers << ": "
+				<< num_values / duration.count() << " values per second" << (correct ? "" : " (WRONG SUM!)") << "\n";
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const std::uint64_t num_values = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	const unsigned num_consumers = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 4;
+	const std::size_t capacity = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 1024;
+	run<Threadsafe_adapter>("Threadsafe_queue", capacity, 1, num_consumers, num_values);
+	run<Mpmc_adapter>("Mpmc_queue", capacity, 1, num_consumers, num_values);
+	run<Threadsafe_adapter>("Threadsafe_queue", capacity, num_consumers, num_consumers, num_values);
+	run<Mpmc_adapter>("Mpmc_queue", capacity, num_consumers, num_consumers, num_values);
+	std::cout.flush();
+}
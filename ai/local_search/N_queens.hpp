@@ -3,135 +3,215 @@
 
 #include <array>
 #include <vector>
+#include <memory>
 #include <random>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 #include <algorithm>
+#include "Random_streams.hpp"
 
-template <unsigned N> class N_queens;
-template <unsigned N> struct Move_piece_generator;
-template <unsigned N> struct Mutagen;
-template <unsigned N> struct Pop_generator;
-template <unsigned N> std::ostream& operator<<(std::ostream&, const N_queens<N>&);
+namespace detail
+{
+
+	/**
+	 * Smallest unsigned type holding the values from 0 to N
+	 */
+	template <unsigned N>
+	using Queens_index = typename std::conditional<(N < 256u),
+			std::uint8_t,
+			typename std::conditional<(N < 65536u), std::uint16_t, std::uint32_t>::type>::type;
+
+	/**
+	 * Array of Size trivially copyable values, stored inline when small and on the heap otherwise, so that
+	 * boards with millions of queens don't end up on the stack. Copying is a memcpy in both cases.
+	 */
+	template <typename T, std::size_t Size, bool = (Size * sizeof(T) <= 4096)>
+	class Board_array
+	{
+	public:
+		T* data() noexcept { return values_.data(); }
+		const T* data() const noexcept { return values_.data(); }
+	private:
+		std::array<T, Size> values_ = {};
+	};
+
+	template <typename T, std::size_t Size>
+	class Board_array<T, Size, false>
+	{
+	public:
+		Board_array() : values_(new T[Size]()) {}
+		Board_array(const Board_array& other) : values_(new T[Size])
+		{
+			std::memcpy(values_.get(), other.values_.get(), Size * sizeof(T));
+		}
+		Board_array(Board_array&&) noexcept = default;
+		Board_array& operator=(const Board_array& other)
+		{
+			if (this != &other)
+			{
+				if (values_ == nullptr)
+				{
+					values_.reset(new T[Size]);
+				}
+				std::memcpy(values_.get(), other.values_.get(), Size * sizeof(T));
+			}
+			return *this;
+		}
+		Board_array& operator=(Board_array&&) noexcept = default;
+		T* data() noexcept { return values_.get(); }
+		const T* data() const noexcept { return values_.get(); }
+	private:
+		std::unique_ptr<T[]> values_;
+	};
+
+}
 
-template <unsigned N>	
+/**
+ * @brief N-queens board with one queen per column
+ *
+ * Besides the row of every queen, the board counts the queens on every row and diagonal, so that moving
+ * a queen and computing how a move would change the number of conflicts take constant time.
+ * Rows and counters are stored in the smallest integer type that fits N.
+ */
+template <unsigned N>
 class N_queens
 {
-	template <unsigned Y> friend std::ostream& operator<<(std::ostream&, const N_queens<Y>&);
-	template <unsigned Y> friend struct Move_piece_generator;
-	template <unsigned Y> friend struct Mutagen;
-	template <unsigned Y> friend struct Pop_generator;
 public:
 	typedef decltype(N) Size_type;
-	typedef std::pair<Size_type, Size_type> Queen;
 	enum { size = N };
 
-	N_queens() = default;
-	N_queens(const N_queens& rhs) : board_(rhs.board_), queens_(rhs.queens_) {}
-	N_queens(N_queens&&) noexcept = default;
-	
-	const std::array<bool, N> operator[](std::size_t n) const { return board_[n]; }
-	N_queens& operator=(const N_queens&) = default;
-	N_queens& operator=(N_queens&&) noexcept = default;
-	
-	inline void add_queen(const Queen& queen);
-	inline void remove_queen(std::size_t n);
-	bool goal() const;
-	std::size_t num_queens() const { return queens_.size(); }
-	std::vector<Size_type> get_free_columns() const;
+	/**
+	 * @brief All the queens in the first row
+	 */
+	N_queens();
+
+	/**
+	 * @return Row of the queen of a column
+	 */
+	Size_type operator[](std::size_t column) const { return rows()[column]; }
+	/**
+	 * @brief Moves the queen of a column to another row, in constant time
+	 */
+	inline void move_queen(Size_type column, Size_type row);
+	/**
+	 * @return Change in the number of conflicts if the queen of column moved to row, in constant time
+	 */
+	inline int move_delta(Size_type column, Size_type row) const;
+	/**
+	 * @return Number of queens other than the one of column on the row and diagonals of (row, column)
+	 */
+	inline unsigned attacks(Size_type column, Size_type row) const;
+	/**
+	 * @return Sum over rows and diagonals of their number of queens minus one
+	 */
+	unsigned conflicts() const noexcept { return conflicts_; }
+	bool goal() const noexcept { return conflicts_ == 0; }
+	/**
+	 * @brief Places the queens at the given rows, in linear time
+	 */
+	template <typename Iterator>
+	void assign(Iterator first_row);
 private:
-	typedef std::array<std::array<bool, N>, N> Board;
+	typedef detail::Queens_index<N> Index;
+	// Rows, then the queens on each row, on each diagonal and on each anti-diagonal
+	static constexpr std::size_t board_size = N + N + 2 * (2 * N - 1);
 
-	Board board_ = {{{{0}}}};
-	std::vector<Queen> queens_;
+	Index* rows() noexcept { return board_.data(); }
+	const Index* rows() const noexcept { return board_.data(); }
+	Index& row_count(Size_type row) noexcept { return board_.data()[N + row]; }
+	Index row_count(Size_type row) const noexcept { return board_.data()[N + row]; }
+	Index& diagonal_count(Size_type column, Size_type row) noexcept { return board_.data()[2 * N + row + column]; }
+	Index diagonal_count(Size_type column, Size_type row) const noexcept { return board_.data()[2 * N + row + column]; }
+	Index& antidiagonal_count(Size_type column, Size_type row) noexcept
+	{
+		return board_.data()[4 * N - 1 + row + (N - 1 - column)];
+	}
+	Index antidiagonal_count(Size_type column, Size_type row) const noexcept
+	{
+		return board_.data()[4 * N - 1 + row + (N - 1 - column)];
+	}
+	// A queen adds a conflict to the lines where there already was a queen
+	void add_to_line(Index& count) noexcept { conflicts_ += (count++ != 0) ? 1 : 0; }
+	void remove_from_line(Index& count) noexcept { conflicts_ -= (--count != 0) ? 1 : 0; }
+
+	detail::Board_array<Index, board_size> board_;
+	unsigned conflicts_ = 0;
 };
 
 template <unsigned N>
-bool N_queens<N>::goal() const 
+N_queens<N>::N_queens()
 {
-	if (queens_.size() != N)
-		return false;
-	for (auto it = queens_.cbegin(); it != queens_.cend(); ++it)
-	{
-		// Straight checks
-		for (Size_type i = 0; i < N; ++i)
-		{
-			if (board_[i][it->second] && i != it->first)
-				return false;
-		}
-		for (Size_type j = 0; j < N; ++j)
-		{
-			if (board_[it->first][j] && j != it->second)
-				return false;
-		}
-		// Diagonal checks
-		for (Size_type i = it->first, j = it->second; i > 0 && j > 0; --i, --j)
-		{
-			if (board_[i-1][j-1])
-				return false;
-		}
-		for (Size_type i = it->first, j = it->second; i < N-1 && j < N-1; ++i, ++j)
-		{
-			if (board_[i+1][j+1])
-				return false;
-		}
-		for (Size_type i = it->first, j = it->second; i > 0 && j < N-1; --i, ++j)
-		{
-			if (board_[i-1][j+1])
-				return false;
-		}
-		for (Size_type i = it->first, j = it->second; i < N-1 && j > 0; ++i, --j)
-		{
-			if (board_[i+1][j-1])
-				return false;
-		}
-	}
-	return true;	
+	const std::vector<Size_type> first_row(N, 0);
+	assign(first_row.cbegin());
 }
 
 template <unsigned N>
-void N_queens<N>::add_queen(const Queen& queen)
+template <typename Iterator>
+void N_queens<N>::assign(Iterator first_row)
 {
-	board_[queen.first][queen.second] = true;
-	queens_.push_back(queen);
+	std::fill(board_.data(), board_.data() + board_size, Index(0));
+	conflicts_ = 0;
+	for (Size_type column = 0; column < N; ++column, ++first_row)
+	{
+		const Size_type row = *first_row;
+		rows()[column] = static_cast<Index>(row);
+		add_to_line(row_count(row));
+		add_to_line(diagonal_count(column, row));
+		add_to_line(antidiagonal_count(column, row));
+	}
 }
 
 template <unsigned N>
-void N_queens<N>::remove_queen(std::size_t n)
+void N_queens<N>::move_queen(Size_type column, Size_type row)
 {
-	board_[queens_[n].first][queens_[n].second] = false;
-	queens_.erase(queens_.cbegin() + n);
+	const Size_type old_row = rows()[column];
+	remove_from_line(row_count(old_row));
+	remove_from_line(diagonal_count(column, old_row));
+	remove_from_line(antidiagonal_count(column, old_row));
+	rows()[column] = static_cast<Index>(row);
+	add_to_line(row_count(row));
+	add_to_line(diagonal_count(column, row));
+	add_to_line(antidiagonal_count(column, row));
 }
 
 template <unsigned N>
-std::vector<typename N_queens<N>::Size_type> N_queens<N>::get_free_columns() const
+int N_queens<N>::move_delta(Size_type column, Size_type row) const
 {
-	std::vector<N_queens<N>::Size_type> result;
-	for (Size_type i = 0; i < N; ++i)
+	const Size_type old_row = rows()[column];
+	if (row == old_row)
 	{
-		result.push_back(i);
+		return 0;
 	}
-	for (const auto& queen : queens_)
-	{
-		result[queen.second] = N+1;
-	}
-	result.erase(std::remove(result.begin(), result.end(), N+1), result.end());
+	// The lines of the two squares are all different
+	const int removed = (row_count(old_row) > 1) + (diagonal_count(column, old_row) > 1) +
+			(antidiagonal_count(column, old_row) > 1);
+	const int added = (row_count(row) != 0) + (diagonal_count(column, row) != 0) +
+			(antidiagonal_count(column, row) != 0);
+	return added - removed;
+}
 
-	return result;
+template <unsigned N>
+unsigned N_queens<N>::attacks(Size_type column, Size_type row) const
+{
+	const unsigned queens = row_count(row) + diagonal_count(column, row) + antidiagonal_count(column, row);
+	return rows()[column] == row ? queens - 3 : queens;
 }
-	
+
 template <unsigned N>
 std::ostream& operator<<(std::ostream& os, const N_queens<N>& rhs)
 {
-	for (auto ity = rhs.board_.cbegin(); ity != rhs.board_.cend(); ++ity)
+	for (typename N_queens<N>::Size_type row = 0; row < N; ++row)
 	{
-		for (auto itx = ity->cbegin(); itx != ity->cend(); ++itx)
+		for (typename N_queens<N>::Size_type column = 0; column < N; ++column)
 		{
-			std::cout << std::setfill (' ') << std::setw(3) << ((*itx) ? 'o' : '.');
+			os << std::setfill (' ') << std::setw(3) << ((rhs[column] == row) ? 'o' : '.');
 		}
-		std::cout << std::endl;
+		os << std::endl;
 	}
 	return os;
 }
@@ -143,9 +223,8 @@ N_queens<N> random_queens_configuration(Random_engine& re)
 	std::uniform_int_distribution<typename N_queens<N>::Size_type> d(0, N-1);
 	for (typename N_queens<N>::Size_type i = 0; i < N; ++i)
 	{
-		typename N_queens<N>::Queen queen = {d(re), i};
-		res.add_queen(queen);
-	}	
+		res.move_queen(i, d(re));
+	}
 	return res;
 }
 
@@ -157,121 +236,71 @@ N_queens<N> random_queens_configuration()
 }
 
 /**
- * @brief Generates successors by moving around the queens
+ * @brief Generates successors by moving a queen to the next or previous row
+ *
+ * Can also propose the move alone, which Energy_evaluation evaluates in constant time.
  */
 template <unsigned N>
 struct Move_piece_generator
 {
-	Move_piece_generator() : re_(std::chrono::system_clock::now().time_since_epoch().count()),
+	typedef typename N_queens<N>::Size_type Size_type;
+	struct Move
+	{
+		Size_type column;
+		Size_type row;
+	};
+
+	Move_piece_generator() : re_(detail::clock_seed()),
 			bernoulli_dist_(0.5),
 			int_dist_(0, N-1) {}
 	N_queens<N> operator()(const N_queens<N>& state)
 	{
 		N_queens<N> successor = state;
-		auto& queen = successor.queens_[int_dist_(re_)];
-		if (queen.first == N-1)
-		{
-			move_queen_down(successor, queen);
-		}
-		else if (queen.first == 0)
+		auto move = propose(state);
+		apply(successor, move);
+		return successor;
+	}
+	Move propose(const N_queens<N>& state)
+	{
+		const auto column = int_dist_(re_);
+		const auto row = state[column];
+		if (row == N-1 || (row != 0 && bernoulli_dist_(re_)))
 		{
-			move_queen_up(successor, queen);
+			return Move{column, row - 1};
 		}
-		else
-		{
-			if (bernoulli_dist_(re_))
-			{
-				move_queen_down(successor, queen);
-			}
-			else
-			{
-				move_queen_up(successor, queen);
-			}
-		}
-		return successor;
-	};
-private:
-	void move_queen_up(N_queens<N>& state, typename N_queens<N>::Queen& queen)
+		return Move{column, row + 1};
+	}
+	void apply(N_queens<N>& state, const Move& move) const
 	{
-		state.board_[queen.first][queen.second] = false;
-		state.board_[++queen.first][queen.second] = true;
+		state.move_queen(move.column, move.row);
 	}
-	void move_queen_down(N_queens<N>& state, typename N_queens<N>::Queen& queen)
+	void seed(unsigned value)
 	{
-		state.board_[queen.first][queen.second] = false;
-		state.board_[--queen.first][queen.second] = true;
+		re_ = Xoshiro128pp(value);
 	}
-
-	std::mt19937 re_;
+private:
+	// Every replica of parallel tempering has a copy: 16 bytes of state instead of the 5 KB of std::mt19937
+	Xoshiro128pp re_;
 	std::bernoulli_distribution bernoulli_dist_;
-	std::uniform_int_distribution<typename N_queens<N>::Size_type> int_dist_;
+	std::uniform_int_distribution<Size_type> int_dist_;
 };
 
 /**
- * @brief Simple energy evaluation functor for n-queens states
+ * @brief Energy of n-queens states: their number of conflicts, which the states keep up to date
  */
 template <unsigned N>
 struct Energy_evaluation
 {
-	float operator()(N_queens<N> state) const
+	float operator()(const N_queens<N>& state) const
 	{
-		unsigned conflicts = 0;
-		unsigned temp = 0;
-		typedef typename N_queens<N>::Size_type Size_type;
-
-		for (Size_type i = 0; i < N; ++i, temp = 0)
-		{
-			for (Size_type j = 0; j < N; ++j)
-				if (state[i][j])
-					++temp;
-			if (temp > 1)
-				conflicts += temp-1;
-		}
-
-		for (Size_type i = 0; i < N; ++i, temp = 0)
-		{
-			for (Size_type j = 0; j < N; ++j)
-				if (state[j][i])
-					++temp;
-			if (temp > 1)
-				conflicts += temp-1;
-		}
-
-		for (Size_type i = 1; i < N; ++i, temp = 0)
-		{
-			for (Size_type j = 0, k = i; k+1 > 0; ++j, --k)
-				if (state[j][k])
-					++temp;
-			if (temp > 1)
-				conflicts += temp-1;
-		}
-		for (Size_type i = 1; i < N; ++i, temp = 0)
-		{
-			for (Size_type j = i, k = N-1; j < N; ++j, --k)
-				if (state[j][k])
-					++temp;
-			if (temp > 1)
-				conflicts += temp-1;
-		}
-
-		for (Size_type i = 0; i < N; ++i, temp = 0)
-		{
-			for (Size_type j = 0, k = i; k < N; ++j, ++k)
-				if (state[j][k])
-					++temp;
-			if (temp > 1)
-				conflicts += temp-1;
-		}
-		for (Size_type i = 1; i < N-1; ++i, temp = 0)
-		{
-			for (Size_type j = i, k = 0; j < N; ++j, ++k)
-				if (state[j][k])
-					++temp;
-			if (temp > 1)
-				conflicts += temp-1;
-		}
-
-		return conflicts;
+		return state.conflicts();
+	}
+	/**
+	 * @return Change in the energy of a state caused by a move
+	 */
+	float delta(const N_queens<N>& state, const typename Move_piece_generator<N>::Move& move) const
+	{
+		return state.move_delta(move.column, move.row);
 	}
 };
 
@@ -284,15 +313,15 @@ struct Mutagen
 	template <typename Random_engine>
     void operator()(N_queens<N>& state, Random_engine& re)
     {
-    	auto& queen = state.queens_[dist_(re)];
-    	auto previous_val = queen.first;
-    	state.board_[queen.first][queen.second] = false;
+		const auto column = dist_(re);
+		const auto previous_row = state[column];
+		Size_type row;
         do
         {
-        	queen.first = dist_(re);
+        	row = dist_(re);
         }
-        while (queen.first == previous_val);
-    	state.board_[queen.first][queen.second] = true;
+        while (row == previous_row && N > 1);
+		state.move_queen(column, row);
     }
 private:
     typedef typename N_queens<N>::Size_type Size_type;
@@ -321,16 +350,32 @@ struct Pop_generator
 	N_queens<N> operator()(const N_queens<N>& x, const N_queens<N>& y, Random_engine& re)
 	{
 		N_queens<N> child;
-	    auto from_x = dist_(re);
-	    for (Size_type i = 0; i < from_x; ++i)
+		(*this)(x, y, re, child);
+	    return child;
+	}
+	/**
+	 * @brief Crossover writing into an existing state: the first columns come from x, the others from y
+	 */
+	template <typename Random_engine>
+	void operator()(const N_queens<N>& x, const N_queens<N>& y, Random_engine& re, N_queens<N>& child)
+	{
+	    const auto from_x = dist_(re);
+	    // Copying a state is cheaper than updating the counters of the queens one by one
+	    child = (from_x < N / 2) ? y : x;
+	    if (from_x < N / 2)
 	    {
-	        child.add_queen(x.queens_[i]);
+	    	for (Size_type column = 0; column < from_x; ++column)
+	    	{
+	    		child.move_queen(column, x[column]);
+	    	}
 	    }
-	    for (Size_type i = from_x; i < N; ++i)
+	    else
 	    {
-	        child.add_queen(y.queens_[i]);
+	    	for (Size_type column = from_x; column < N; ++column)
+	    	{
+	    		child.move_queen(column, y[column]);
+	    	}
 	    }
-	    return child;
 	}
 private:
 	typedef typename N_queens<N>::Size_type Size_type;
@@ -0,0 +1,47 @@
+/**
+	Counts all the solutions of the N-queens puzzle on the thread pool, as a CPU benchmark, checking them
+	against the known counts. Prints the nodes (placed queens) per second, in total and on average per thread,
+	then the tasks and the idle time of every worker of the pool.
+	Usage: N_queens_count [N] [number of threads] [rows enumerated before splitting into tasks]
+ */
+
+#include "Queens_counter.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+namespace
+{
+
+	// Number of solutions for N from 0 to 18
+	const std::uint64_t known_solutions[] = {1, 1, 0, 0, 2, 10, 4, 40, 92, 352, 724, 2680, 14200, 73712, 365596,
+			2279184, 14772512, 95815104, 666090624};
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 15;
+	const unsigned num_threads = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+	const unsigned split_rows = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 4;
+	Thread_pool pool(num_threads);
+	const Thread_pool_stats stats_start = pool.stats();
+	const auto start = std::chrono::steady_clock::now();
+	const Queens_count count = count_queens_solutions(pool, size, split_rows);
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	const Thread_pool_stats stats = pool.stats() - stats_start;
+	const double nodes_per_second = count.nodes / duration.count();
+	std::cout << "N = " << size << ", threads: " << num_threads << "\nSolutions: " << count.solutions;
+	if (size < sizeof(known_solutions) / sizeof(known_solutions[0]))
+	{
+		std::cout << (count.solutions == known_solutions[size] ? " (correct)" : " (WRONG)");
+	}
+	std::cout << "\nNodes: " << count.nodes << "\nTime: " << std::fixed << std::setprecision(3) << duration.count()
+			<< " s\nNodes per second: " << std::setprecision(0) << nodes_per_second
+			<< "\nNodes per second per thread (average): " << nodes_per_second / std::max(1u, num_threads) << "\n\n";
+	print_report(std::cout, stats);
+}
@@ -0,0 +1,32 @@
+/**
+	Solves the N-queens puzzle with min-conflicts local search for boards of growing size.
+	Usage: N_queens_mc [N...]
+ */
+
+#include "Min_conflicts.hpp"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+int main(int argc, char* argv[])
+{
+	std::vector<unsigned> sizes;
+	for (int i = 1; i < argc; ++i)
+	{
+		sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+	}
+	if (sizes.empty())
+	{
+		sizes = {8, 1000, 100000, 1000000};
+	}
+	Min_conflicts_queens solver;
+	for (auto n : sizes)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const auto rows = solver(n);
+		const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+		std::cout << "N = " << n << ": " << duration.count() << " ms, " << solver.steps() << " steps, "
+				<< solver.restarts() << " restarts, attacking pairs " << count_attacks(rows) << std::endl;
+	}
+}
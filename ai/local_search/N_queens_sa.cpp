@@ -1,5 +1,6 @@
 #include "N_queens.hpp"
 #include "Simulated_annealing.hpp"
+#include "Parallel_tempering.hpp"
 #include <iostream>	
 	
 struct Simple_schedule
@@ -11,11 +12,23 @@ struct Simple_schedule
 	}
 };
 
+template <typename State> void print(const State& result);
+
 int main()
 {
 	Simulated_annealing<N_queens<8>, Move_piece_generator<8>, Energy_evaluation<8>, Simple_schedule> sa;
 	// It might need a few attempts to find a goal state!
-	auto result = sa(random_queens_configuration<8>());
+	std::cout << "--- Simulated annealing\n";
+	print(sa(random_queens_configuration<8>()));
+	// Replicas at several temperatures, stopping at the first goal state
+	Parallel_tempering<N_queens<8>, Move_piece_generator<8>, Energy_evaluation<8>, Simple_schedule> pt;
+	std::cout << "\n--- Parallel tempering\n";
+	print(pt(random_queens_configuration<8>()));
+}
+
+template <typename State>
+void print(const State& result)
+{
 	std::cout << "Is goal? " << std::boolalpha << result.goal() << std::endl;
 	std::cout << result << std::endl;
 	std::cout << "Energy: " << Energy_evaluation<8>{}(result) << std::endl;
@@ -0,0 +1,265 @@
+#ifndef AI_SEARCHING_PARALLEL_TEMPERING_HPP_
+#define AI_SEARCHING_PARALLEL_TEMPERING_HPP_
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
+#include "Simulated_annealing.hpp"
+#include "Fork_join.hpp"
+
+/**
+ * @brief Parallel tempering (replica exchange) on top of simulated annealing
+ *
+ * Several replicas of the state anneal in parallel on a Thread_pool, each at the temperature of the schedule
+ * multiplied by a power of temperature_ratio. Every swap_interval iterations, replicas at adjacent temperatures
+ * exchange their temperatures with the Metropolis criterion, so that good states found at high temperatures
+ * reach the low ones. All the replicas stop as soon as one reaches the target energy, zero by default.
+ * With a temperature ratio of 1 the replicas are independent annealing runs (multi-start annealing).
+ *
+ * Every replica draws from its own stream of the engine, and a replica stops only once it's past the iteration
+ * at which another one reached the target, so a seed determines the result whatever the number of threads.
+ *
+ * @tparam State represents the states of the problem
+ * @tparam Generator callable returning a random successor of a state, or proposing moves (see Simulated_annealing);
+ * every replica uses a copy, reseeded if the generator has a seed(unsigned) member
+ * @tparam Energy callable returning the estimated energy of a state (the lower the better)
+ * @tparam Schedule callable mapping time (intended as number of iterations) to the temperature of the coldest replica
+ * @tparam Engine random engine constructible from a seed and a stream id
+ */
+template <typename State, typename Generator, typename Energy, typename Schedule, typename Engine = Philox4x32>
+class Parallel_tempering
+{
+public:
+	typedef State State_type;
+	Parallel_tempering(const Generator& generator = Generator(),
+			const Energy& energy = Energy(),
+			const Schedule& schedule = Schedule(),
+			unsigned num_replicas = std::max(2u, std::thread::hardware_concurrency()),
+			float temperature_ratio = 2.0f,
+			unsigned swap_interval = 100)
+	: generator_(generator),
+			energy_(energy),
+			schedule_(schedule),
+			num_replicas_(std::max(1u, num_replicas)),
+			temperature_ratio_(temperature_ratio),
+			swap_interval_(std::max(1u, swap_interval)),
+			seed_(detail::clock_seed())
+	{}
+	/**
+	 * @brief Starts all the replicas from the same state
+	 */
+	State operator()(const State& start, unsigned num_threads = std::thread::hardware_concurrency());
+	/**
+	 * @brief Starts a replica from every state, from the coldest to the hottest
+	 * @throw std::invalid_argument if there are no states
+	 */
+	State operator()(std::vector<State> starts, unsigned num_threads = std::thread::hardware_concurrency());
+	/**
+	 * @brief Sets the seed of the following runs
+	 */
+	void seed(std::uint64_t value) noexcept
+	{
+		seed_ = value;
+		runs_ = 0;
+	}
+	/**
+	 * @brief Sets the energy at which the following runs stop
+	 */
+	void target(float value) noexcept { target_ = value; }
+	/**
+	 * @return Whether a replica reached the target energy in the last run
+	 */
+	bool solved() const noexcept { return solved_; }
+	/**
+	 * @return Number of iterations of every replica in the last run
+	 */
+	unsigned long long iterations() const noexcept { return iterations_; }
+	/**
+	 * @return Ratio of the accepted exchanges of temperatures in the last run
+	 */
+	double swap_rate() const noexcept { return swap_attempts_ != 0 ? static_cast<double>(swaps_) / swap_attempts_ : 0; }
+private:
+	struct Replica
+	{
+		Replica(State start,
+				const Generator& generator,
+				const Energy& energy,
+				const Schedule& schedule,
+				const Engine& engine)
+		: generator(generator), energy(energy), schedule(schedule),
+				walk(std::move(start), this->generator, this->energy, engine)
+		{}
+		Generator generator;
+		Energy energy;
+		Schedule schedule;
+		detail::Annealing_walk<State, Generator, Energy, Engine> walk;
+		// Position in the temperature ladder, 0 is the coldest
+		unsigned rung = 0;
+		bool cooled = false;
+		// Iteration at which the replica reached the target energy
+		unsigned long long solved_at = never;
+	};
+	static constexpr unsigned long long never = std::numeric_limits<unsigned long long>::max();
+
+	void run_round(Replica& replica,
+			unsigned long long first,
+			unsigned long long last,
+			std::atomic<unsigned long long>& solved_at) const;
+	void exchange(std::vector<std::unique_ptr<Replica>>& replicas, std::vector<unsigned>& ladder, unsigned long long t,
+			unsigned parity);
+	float scale(unsigned rung) const { return std::pow(temperature_ratio_, static_cast<float>(rung)); }
+
+	Generator generator_;
+	Energy energy_;
+	Schedule schedule_;
+	unsigned num_replicas_;
+	float temperature_ratio_;
+	unsigned swap_interval_;
+	std::uint64_t seed_;
+	std::uint64_t runs_ = 0;
+	float target_ = 0;
+	Engine re_;
+	bool solved_ = false;
+	unsigned long long iterations_ = 0;
+	unsigned long long swaps_ = 0;
+	unsigned long long swap_attempts_ = 0;
+};
+
+template <typename State, typename Generator, typename Energy, typename Schedule, typename Engine>
+State Parallel_tempering<State, Generator, Energy, Schedule, Engine>::operator()(const State& start, unsigned num_threads)
+{
+	return (*this)(std::vector<State>(num_replicas_, start), num_threads);
+}
+
+template <typename State, typename Generator, typename Energy, typename Schedule, typename Engine>
+State Parallel_tempering<State, Generator, Energy, Schedule, Engine>::operator()(std::vector<State> starts, unsigned num_threads)
+{
+	if (starts.empty())
+	{
+		throw std::invalid_argument("Parallel_tempering needs at least one starting state");
+	}
+	const unsigned num_replicas = static_cast<unsigned>(starts.size());
+	const std::uint64_t run_seed = detail::run_seed(seed_, runs_++);
+	// Streams 2i and 2i + 1 belong to replica i, the last one to the exchanges
+	re_ = Engine(run_seed, std::numeric_limits<std::uint64_t>::max());
+	std::vector<std::unique_ptr<Replica>> replicas;
+	std::vector<unsigned> ladder(num_replicas);
+	std::atomic<unsigned long long> solved_at(never);
+	for (unsigned i = 0; i < num_replicas; ++i)
+	{
+		replicas.push_back(std::make_unique<Replica>(std::move(starts[i]), generator_, energy_, schedule_,
+				Engine(run_seed, 2 * i)));
+		detail::seed_generator(replicas.back()->generator, Engine(run_seed, 2 * i + 1)());
+		replicas.back()->rung = i;
+		ladder[i] = i;
+		if (replicas.back()->walk.energy() <= target_)
+		{
+			replicas.back()->solved_at = 0;
+			solved_at.store(0, std::memory_order_relaxed);
+		}
+	}
+	swaps_ = 0;
+	swap_attempts_ = 0;
+	// The calling thread runs replicas while waiting for the round
+	Thread_pool pool(std::min(num_threads, num_replicas) - (num_threads != 0 ? 1 : 0));
+	unsigned long long t = 1;
+	for (unsigned parity = 0; solved_at.load(std::memory_order_relaxed) == never; parity ^= 1)
+	{
+		const unsigned long long last = t + swap_interval_;
+		parallel_for(pool, 0u, num_replicas, 1u, [&](unsigned first_replica, unsigned last_replica)
+				{
+					for (unsigned i = first_replica; i < last_replica; ++i)
+					{
+						run_round(*replicas[i], t, last, solved_at);
+					}
+				});
+		t = last;
+		if (replicas.front()->cooled)
+		{
+			break;
+		}
+		exchange(replicas, ladder, t, parity);
+	}
+	solved_ = solved_at.load(std::memory_order_relaxed) != never;
+	iterations_ = solved_ ? solved_at.load(std::memory_order_relaxed) : t - 1;
+	// The first replica to reach the target, or the one which found the best state
+	auto best = std::min_element(replicas.begin(), replicas.end(), [](const auto& lhs, const auto& rhs)
+			{
+				return lhs->solved_at < rhs->solved_at ||
+						(lhs->solved_at == rhs->solved_at && lhs->walk.best_energy() < rhs->walk.best_energy());
+			});
+	return std::move((*best)->walk).best();
+}
+
+template <typename State, typename Generator, typename Energy, typename Schedule, typename Engine>
+void Parallel_tempering<State, Generator, Energy, Schedule, Engine>::run_round(Replica& replica,
+		unsigned long long first,
+		unsigned long long last,
+		std::atomic<unsigned long long>& solved_at) const
+{
+	const float rung_scale = scale(replica.rung);
+	for (unsigned long long t = first; t < last; ++t)
+	{
+		// Iterations up to the earliest solution run in every replica, so the first solution doesn't depend on timing
+		unsigned long long earliest = solved_at.load(std::memory_order_relaxed);
+		if (t > earliest)
+		{
+			return;
+		}
+		const float temp = replica.schedule(t);
+		if (temp == 0)
+		{
+			replica.cooled = true;
+			return;
+		}
+		replica.walk.step(temp * rung_scale);
+		if (replica.walk.energy() <= target_)
+		{
+			replica.solved_at = t;
+			while (t < earliest && !solved_at.compare_exchange_weak(earliest, t, std::memory_order_relaxed))
+			{
+			}
+			return;
+		}
+	}
+}
+
+template <typename State, typename Generator, typename Energy, typename Schedule, typename Engine>
+void Parallel_tempering<State, Generator, Energy, Schedule, Engine>::exchange(std::vector<std::unique_ptr<Replica>>& replicas,
+		std::vector<unsigned>& ladder,
+		unsigned long long t,
+		unsigned parity)
+{
+	const float temp = schedule_(t);
+	if (temp == 0)
+	{
+		return;
+	}
+	// Alternating between even and odd pairs lets a replica move by more than one rung in two rounds
+	std::uniform_real_distribution<float> dist(0, 1);
+	for (unsigned rung = parity; rung + 1 < ladder.size(); rung += 2)
+	{
+		Replica& colder = *replicas[ladder[rung]];
+		Replica& hotter = *replicas[ladder[rung + 1]];
+		const float beta_difference = 1 / (temp * scale(rung)) - 1 / (temp * scale(rung + 1));
+		const float p = std::exp((colder.walk.energy() - hotter.walk.energy()) * beta_difference);
+		++swap_attempts_;
+		if (p >= 1 || dist(re_) < p)
+		{
+			++swaps_;
+			std::swap(ladder[rung], ladder[rung + 1]);
+			colder.rung = rung + 1;
+			hotter.rung = rung;
+		}
+	}
+}
+
+#endif
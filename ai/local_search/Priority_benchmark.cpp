@@ -0,0 +1,153 @@
+/**
+	Measures how long a task waits before starting while Thread_pool is saturated by background work.
+	Chains of background tasks keep every worker busy, each task submitting its successor, while probe
+	tasks are submitted from outside the pool: first probes of high and normal priority behind background
+	tasks of normal priority, then probes of low priority behind the same background, whose latency is
+	bounded by the starvation avoidance of the pool.
+	Finally the pool is left idle until its workers park, then a batch of low priority tasks and a task of high
+	priority are submitted: the tasks of low priority started after the high one was submitted but before it
+	should be none, whatever the workers did while idle.
+	Usage: Priority_benchmark [number of threads] [number of probes] [microseconds per background task]
+ */
+
+#include "Thread_pool.hpp"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace
+{
+
+	typedef std::chrono::steady_clock Clock;
+
+	void busy_wait(std::chrono::microseconds duration)
+	{
+		const auto end = Clock::now() + duration;
+		while (Clock::now() < end)
+		{
+		}
+	}
+
+	struct Background
+	{
+		Thread_pool& pool;
+		Task_priority priority;
+		std::chrono::microseconds task_duration;
+		std::atomic<bool> stop{false};
+		std::atomic<unsigned> running{0};
+	};
+
+	void background_task(Background& background)
+	{
+		busy_wait(background.task_duration);
+		if (background.stop.load(std::memory_order_relaxed))
+		{
+			background.running.fetch_sub(1, std::memory_order_release);
+			return;
+		}
+		background.pool.post([&background]() { background_task(background); }, background.priority);
+	}
+
+	void measure(unsigned num_threads,
+			unsigned num_probes,
+			std::chrono::microseconds task_duration,
+			Task_priority background_priority,
+			Task_priority probe_priority,
+			const char* name)
+	{
+		Thread_pool pool(num_threads);
+		Background background{pool, background_priority, task_duration};
+		// Several chains per worker, so that the queues are never empty
+		const unsigned num_chains = 4 * std::max(1u, num_threads);
+		background.running = num_chains;
+		for (unsigned i = 0; i < num_chains; ++i)
+		{
+			pool.post([&background]() { background_task(background); }, background_priority);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		long long total = 0;
+		long long worst = 0;
+		for (unsigned i = 0; i < num_probes; ++i)
+		{
+			const auto submitted = Clock::now();
+			const auto started = pool.submit([]() { return Clock::now(); }, probe_priority).get();
+			const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(started - submitted).count();
+			total += latency;
+			worst = std::max<long long>(worst, latency);
+		}
+		background.stop = true;
+		while (background.running.load(std::memory_order_acquire) != 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::cout << name << ": " << total / std::max(1u, num_probes) << " microseconds on average, "
+				<< worst << " at worst" << std::endl;
+	}
+
+	void measure_idle(unsigned num_threads, unsigned num_rounds, std::chrono::microseconds task_duration)
+	{
+		Thread_pool pool(num_threads);
+		const unsigned num_low = 4 * std::max(1u, num_threads);
+		unsigned long long total_ahead = 0;
+		unsigned worst_ahead = 0;
+		long long total = 0;
+		long long worst = 0;
+		for (unsigned i = 0; i < num_rounds; ++i)
+		{
+			// Long enough for the workers to poll many times and park
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			std::atomic<unsigned> started{0};
+			std::atomic<unsigned> finished{0};
+			for (unsigned j = 0; j < num_low; ++j)
+			{
+				pool.post([&started, &finished, task_duration]()
+						{
+							started.fetch_add(1, std::memory_order_relaxed);
+							busy_wait(task_duration);
+							finished.fetch_add(1, std::memory_order_release);
+						}, Task_priority::low);
+			}
+			const unsigned started_before = started.load(std::memory_order_relaxed);
+			const auto submitted = Clock::now();
+			const auto result = pool.submit([&started]()
+					{
+						return std::make_pair(Clock::now(), started.load(std::memory_order_relaxed));
+					}, Task_priority::high).get();
+			const unsigned ahead = result.second - started_before;
+			const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(result.first - submitted).count();
+			total_ahead += ahead;
+			worst_ahead = std::max(worst_ahead, ahead);
+			total += latency;
+			worst = std::max<long long>(worst, latency);
+			while (finished.load(std::memory_order_acquire) != num_low)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		std::cout << "High priority after low priority, idle pool: " << total / std::max(1u, num_rounds)
+				<< " microseconds on average, " << worst << " at worst; low priority tasks started ahead "
+				<< static_cast<double>(total_ahead) / std::max(1u, num_rounds) << " on average, " << worst_ahead
+				<< " at worst" << std::endl;
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned num_threads = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+	const unsigned num_probes = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 100;
+	const std::chrono::microseconds task_duration((argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 100);
+	std::cout << "Threads: " << num_threads << ", background tasks of " << task_duration.count()
+			<< " microseconds\nLatency of the probes\n";
+	measure(num_threads, num_probes, task_duration, Task_priority::normal, Task_priority::high,
+			"High priority, normal background");
+	measure(num_threads, num_probes, task_duration, Task_priority::normal, Task_priority::normal,
+			"Normal priority, normal background");
+	measure(num_threads, num_probes, task_duration, Task_priority::normal, Task_priority::low,
+			"Low priority, normal background");
+	measure_idle(num_threads, std::min(num_probes, 50u), task_duration);
+}
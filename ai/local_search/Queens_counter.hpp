@@ -0,0 +1,155 @@
+#ifndef AI_SEARCHING_QUEENS_COUNTER_HPP_
+#define AI_SEARCHING_QUEENS_COUNTER_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include "Fork_join.hpp"
+
+/**
+ * Solutions of the N-queens puzzle and nodes (placed queens) visited to count them
+ */
+struct Queens_count
+{
+	Queens_count& operator+=(const Queens_count& rhs)
+	{
+		solutions += rhs.solutions;
+		nodes += rhs.nodes;
+		return *this;
+	}
+	std::uint64_t solutions = 0;
+	std::uint64_t nodes = 0;
+};
+
+namespace detail
+{
+
+	/**
+	 * Queens placed on the first rows. The occupied columns and diagonals of the next row are bitmasks,
+	 * weight is the number of mirror images the placement stands for
+	 */
+	struct Queens_prefix
+	{
+		std::uint32_t columns;
+		std::uint32_t left_diagonals;
+		std::uint32_t right_diagonals;
+		unsigned row;
+		unsigned weight;
+	};
+
+	inline void count_queens_from(std::uint32_t all,
+			std::uint32_t columns,
+			std::uint32_t left_diagonals,
+			std::uint32_t right_diagonals,
+			Queens_count& count)
+	{
+		if (columns == all)
+		{
+			++count.solutions;
+			return;
+		}
+		std::uint32_t free = all & ~(columns | left_diagonals | right_diagonals);
+		while (free != 0)
+		{
+			const std::uint32_t bit = free & (0 - free);
+			free ^= bit;
+			++count.nodes;
+			count_queens_from(all, columns | bit, (left_diagonals | bit) << 1, (right_diagonals | bit) >> 1, count);
+		}
+	}
+
+	/**
+	 * Places a queen on the next row of a prefix, on the columns of allowed
+	 */
+	inline void extend_queens_prefix(const Queens_prefix& prefix,
+			std::uint32_t allowed,
+			unsigned weight,
+			std::vector<Queens_prefix>& prefixes)
+	{
+		std::uint32_t free = allowed & ~(prefix.columns | prefix.left_diagonals | prefix.right_diagonals);
+		while (free != 0)
+		{
+			const std::uint32_t bit = free & (0 - free);
+			free ^= bit;
+			prefixes.push_back(Queens_prefix{prefix.columns | bit, (prefix.left_diagonals | bit) << 1,
+					(prefix.right_diagonals | bit) >> 1, prefix.row + 1, weight});
+		}
+	}
+
+}
+
+/**
+ * @brief Counts the solutions of the N-queens puzzle with a bitmask backtracking search on a Thread_pool
+ *
+ * Mirroring the board halves the search: the queen of the first row is placed on the left half only and
+ * counts twice; when N is odd and that queen is in the middle column, the queen of the second row is placed
+ * on the left half instead. The placements of the first split_rows queens are enumerated, then every one
+ * of them is a task completing the search.
+ *
+ * @param size N, from 1 to 32
+ */
+inline Queens_count count_queens_solutions(Thread_pool& pool, unsigned size, unsigned split_rows = 4)
+{
+	if (size == 0 || size > 32)
+	{
+		throw std::invalid_argument("count_queens_solutions supports boards of 1 to 32 queens");
+	}
+	const std::uint32_t all = (size == 32) ? ~std::uint32_t(0) : (std::uint32_t(1) << size) - 1;
+	const std::uint32_t left_half = (std::uint32_t(1) << (size / 2)) - 1;
+	Queens_count count;
+	std::vector<detail::Queens_prefix> prefixes;
+	const detail::Queens_prefix empty{0, 0, 0, 0, 1};
+	detail::extend_queens_prefix(empty, left_half, 2, prefixes);
+	if (size % 2 == 1)
+	{
+		std::vector<detail::Queens_prefix> middle;
+		detail::extend_queens_prefix(empty, std::uint32_t(1) << (size / 2), 1, middle);
+		count.nodes += 1;
+		if (size == 1)
+		{
+			count.solutions = 1;
+		}
+		else
+		{
+			detail::extend_queens_prefix(middle.front(), left_half, 2, prefixes);
+		}
+	}
+	count.nodes += prefixes.size();
+	// Breadth first, so that the tasks are of similar sizes
+	for (bool extended = true; extended; )
+	{
+		extended = false;
+		std::vector<detail::Queens_prefix> next;
+		for (const auto& prefix : prefixes)
+		{
+			if (prefix.row >= split_rows || prefix.columns == all)
+			{
+				next.push_back(prefix);
+				continue;
+			}
+			const std::size_t first = next.size();
+			detail::extend_queens_prefix(prefix, all, prefix.weight, next);
+			count.nodes += next.size() - first;
+			extended = true;
+		}
+		prefixes.swap(next);
+	}
+	count += parallel_reduce(pool, std::size_t(0), prefixes.size(), std::size_t(1), Queens_count(),
+			[&prefixes, all](std::size_t first, std::size_t last, Queens_count result)
+			{
+				for (std::size_t i = first; i < last; ++i)
+				{
+					const detail::Queens_prefix& prefix = prefixes[i];
+					Queens_count prefix_count;
+					detail::count_queens_from(all, prefix.columns, prefix.left_diagonals, prefix.right_diagonals,
+							prefix_count);
+					result.solutions += prefix_count.solutions * prefix.weight;
+					result.nodes += prefix_count.nodes;
+				}
+				return result;
+			},
+			[](Queens_count lhs, const Queens_count& rhs) { return lhs += rhs; });
+	return count;
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef AI_SEARCHING_RANDOM_STREAMS_HPP_
+#define AI_SEARCHING_RANDOM_STREAMS_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Random engines whose independent streams are identified by (seed, stream id), so that every thread,
+ * individual or replica can derive its own stream without sharing state: the numbers drawn depend only
+ * on the seed and on the stream, not on the thread which draws them. Both engines satisfy the requirements
+ * of the standard distributions and produce 32-bit numbers.
+ */
+
+namespace detail
+{
+
+	/**
+	 * Finalizer of SplitMix64, a bijective mix of 64-bit values
+	 */
+	inline std::uint64_t mix64(std::uint64_t x) noexcept
+	{
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	/**
+	 * Seed of run number run of an algorithm seeded with seed
+	 */
+	inline std::uint64_t run_seed(std::uint64_t seed, std::uint64_t run) noexcept
+	{
+		return mix64(seed + run * 0x9E3779B97F4A7C15ull);
+	}
+
+	inline std::uint64_t clock_seed() noexcept
+	{
+		return static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+	}
+
+}
+
+/**
+ * @brief Philox4x32-10 counter-based engine (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+ *
+ * The seed is the key and the stream id the upper half of the 128-bit counter: the state is 44 bytes,
+ * creating a stream costs nothing and every block of four numbers is ten rounds of multiplications.
+ */
+class Philox4x32
+{
+public:
+	typedef std::uint32_t result_type;
+
+	explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) noexcept
+	: key_{{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)}},
+			counter_{{0, 0, static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)}}
+	{}
+	static constexpr result_type min() noexcept { return 0; }
+	static constexpr result_type max() noexcept { return 0xFFFFFFFFu; }
+	result_type operator()() noexcept
+	{
+		if (index_ == 4)
+		{
+			output_ = block(counter_, key_);
+			// The lower half of the counter numbers the blocks of the stream
+			if (++counter_[0] == 0)
+			{
+				++counter_[1];
+			}
+			index_ = 0;
+		}
+		return output_[index_++];
+	}
+	void discard(unsigned long long n) noexcept
+	{
+		for (; n != 0; --n)
+		{
+			(*this)();
+		}
+	}
+	/**
+	 * @return The ten rounds of Philox4x32 applied to a counter
+	 */
+	static std::array<std::uint32_t, 4> block(std::array<std::uint32_t, 4> counter,
+			std::array<std::uint32_t, 2> key) noexcept
+	{
+		for (unsigned round = 0; round < 10; ++round)
+		{
+			const std::uint64_t product0 = static_cast<std::uint64_t>(0xD2511F53u) * counter[0];
+			const std::uint64_t product1 = static_cast<std::uint64_t>(0xCD9E8D57u) * counter[2];
+			counter = {{static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+					static_cast<std::uint32_t>(product1),
+					static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+					static_cast<std::uint32_t>(product0)}};
+			key[0] += 0x9E3779B9u;
+			key[1] += 0xBB67AE85u;
+		}
+		return counter;
+	}
+private:
+	std::array<std::uint32_t, 2> key_;
+	std::array<std::uint32_t, 4> counter_;
+	std::array<std::uint32_t, 4> output_ = {};
+	unsigned index_ = 4;
+};
+
+/**
+ * @brief xoshiro128++ (Blackman and Vigna), a fast engine with 16 bytes of state
+ *
+ * The state of a stream is obtained mixing the seed and the stream id with SplitMix64: streams are not
+ * provably disjoint like those of Philox4x32, but their overlap is negligible for simulations.
+ */
+class Xoshiro128pp
+{
+public:
+	typedef std::uint32_t result_type;
+
+	explicit Xoshiro128pp(std::uint64_t seed = 0, std::uint64_t stream = 0) noexcept
+	{
+		std::uint64_t x = seed ^ detail::mix64(stream + 0x632BE59BD9B4E019ull);
+		for (unsigned i = 0; i < 4; i += 2)
+		{
+			x += 0x9E3779B97F4A7C15ull;
+			const std::uint64_t z = detail::mix64(x);
+			state_[i] = static_cast<std::uint32_t>(z);
+			state_[i + 1] = static_cast<std::uint32_t>(z >> 32);
+		}
+	}
+	static constexpr result_type min() noexcept { return 0; }
+	static constexpr result_type max() noexcept { return 0xFFFFFFFFu; }
+	result_type operator()() noexcept
+	{
+		const std::uint32_t result = rotl(state_[0] + state_[3], 7) + state_[0];
+		const std::uint32_t t = state_[1] << 9;
+		state_[2] ^= state_[0];
+		state_[3] ^= state_[1];
+		state_[1] ^= state_[2];
+		state_[0] ^= state_[3];
+		state_[2] ^= t;
+		state_[3] = rotl(state_[3], 11);
+		return result;
+	}
+	void discard(unsigned long long n) noexcept
+	{
+		for (; n != 0; --n)
+		{
+			(*this)();
+		}
+	}
+private:
+	static std::uint32_t rotl(std::uint32_t x, int k) noexcept { return (x << k) | (x >> (32 - k)); }
+
+	std::array<std::uint32_t, 4> state_;
+};
+
+#endif
@@ -0,0 +1,128 @@
+/**
+	Measures the speed of the random engines of Random_streams.hpp against std::mt19937, then checks that
+	GA, PGA, Simulated_annealing and Parallel_tempering give the same result from the same seed, whatever
+	the number of threads, and times GA and PGA with both engines.
+	Usage: Rng_benchmark [seed] [number of threads]
+ */
+
+#include "Random_streams.hpp"
+#include "N_queens.hpp"
+#include "GA.hpp"
+#include "Simulated_annealing.hpp"
+#include "Parallel_tempering.hpp"
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+
+	typedef std::chrono::steady_clock Clock;
+	constexpr unsigned size = 32;
+
+	template <typename Engine>
+	void measure_engine(const char* name, Engine engine)
+	{
+		static constexpr unsigned count = 100000000;
+		std::uint32_t sum = 0;
+		const auto start = Clock::now();
+		for (unsigned i = 0; i < count; ++i)
+		{
+			sum += engine();
+		}
+		const std::chrono::duration<double> duration = Clock::now() - start;
+		std::cout << std::setw(14) << std::left << name << std::right << std::setw(6) << sizeof(Engine) << " bytes, "
+				<< std::fixed << std::setprecision(0) << count / duration.count() / 1e6 << "M numbers/s"
+				<< " (checksum " << sum << ")" << std::endl;
+	}
+
+	template <unsigned N>
+	bool same(const N_queens<N>& lhs, const N_queens<N>& rhs)
+	{
+		for (unsigned column = 0; column < N; ++column)
+		{
+			if (lhs[column] != rhs[column])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const char* verdict(bool identical)
+	{
+		return identical ? "identical" : "DIFFERENT";
+	}
+
+	struct Linear_schedule
+	{
+		float operator()(unsigned long long t) const
+		{
+			return t < 100000 ? 0.5f * (100000 - t) / 100000 : 0.0f;
+		}
+	};
+
+	template <typename Engine>
+	void check_ga(const char* name, std::uint64_t seed, unsigned num_threads)
+	{
+		static constexpr unsigned generations = 200;
+		static constexpr unsigned population = 1000;
+		GA<N_queens<size>, Pop_generator<size>, Energy_evaluation<size>, Mutagen<size>, Rank_selection, Engine> ga;
+		PGA<N_queens<size>, Pop_generator<size>, Energy_evaluation<size>, Mutagen<size>, Rank_selection, Engine> pga;
+		ga.seed(seed);
+		auto start = Clock::now();
+		const auto reference = ga(generations, population);
+		const std::chrono::duration<double, std::milli> ga_time = Clock::now() - start;
+		pga.seed(seed);
+		const auto one_thread = pga(generations, population, 1);
+		pga.seed(seed);
+		start = Clock::now();
+		const auto many_threads = pga(generations, population, num_threads);
+		const std::chrono::duration<double, std::milli> pga_time = Clock::now() - start;
+		std::cout << name << ": GA " << std::setprecision(1) << ga_time.count() << " ms, PGA with " << num_threads
+				<< " threads " << pga_time.count() << " ms, conflicts " << reference.conflicts()
+				<< "; PGA with 1 thread " << verdict(same(reference, one_thread)) << ", with " << num_threads
+				<< " threads " << verdict(same(reference, many_threads)) << std::endl;
+	}
+
+	void check_annealing(std::uint64_t seed, unsigned num_threads)
+	{
+		typedef N_queens<size> State;
+		std::mt19937 re(seed);
+		const State start = random_queens_configuration<size>(re);
+		Simulated_annealing<State, Move_piece_generator<size>, Energy_evaluation<size>, Linear_schedule> sa;
+		sa.seed(seed);
+		const auto first = sa(start);
+		sa.seed(seed);
+		const auto second = sa(start);
+		std::cout << "Simulated_annealing: conflicts " << first.conflicts() << ", second run "
+				<< verdict(same(first, second)) << std::endl;
+		Parallel_tempering<State, Move_piece_generator<size>, Energy_evaluation<size>, Linear_schedule> pt(
+				Move_piece_generator<size>(), Energy_evaluation<size>(), Linear_schedule(), 4);
+		pt.seed(seed);
+		const auto one_thread = pt(start, 1);
+		pt.seed(seed);
+		const auto many_threads = pt(start, num_threads);
+		std::cout << "Parallel_tempering: conflicts " << one_thread.conflicts() << ", with " << num_threads
+				<< " threads " << verdict(same(one_thread, many_threads)) << std::endl;
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const std::uint64_t seed = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 42;
+	const unsigned num_threads = (argc > 2) ? std::strtoul(argv[2], nullptr, 10)
+			: std::max(4u, std::thread::hardware_concurrency());
+	measure_engine("std::mt19937", std::mt19937(static_cast<std::uint32_t>(seed)));
+	measure_engine("Philox4x32", Philox4x32(seed));
+	measure_engine("Xoshiro128pp", Xoshiro128pp(seed));
+	std::cout << "\n" << size << " queens, seed " << seed << "\n";
+	check_ga<Philox4x32>("Philox4x32", seed, num_threads);
+	check_ga<Xoshiro128pp>("Xoshiro128pp", seed, num_threads);
+	check_annealing(seed, num_threads);
+}
@@ -0,0 +1,68 @@
+/**
+	Measures the iterations per second of Simulated_annealing on N-queens boards of 8 and 1000 queens,
+	with moves evaluated through their energy delta and with whole successors (the adapter used by generators
+	which return states), along with the conflicts left in the result.
+	Usage: Sa_benchmark [iterations]
+ */
+
+#include "N_queens.hpp"
+#include "Simulated_annealing.hpp"
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+namespace
+{
+
+	/**
+	 * Temperature decreasing linearly to zero in a fixed number of iterations
+	 */
+	struct Linear_schedule
+	{
+		float operator()(unsigned long long t) const
+		{
+			return t < iterations ? 2.0f * (iterations - t) / iterations : 0.0f;
+		}
+		unsigned long long iterations;
+	};
+
+	/**
+	 * Hides the moves of Move_piece_generator, so that annealing creates whole successors
+	 */
+	template <unsigned N>
+	struct Successor_generator
+	{
+		N_queens<N> operator()(const N_queens<N>& state) { return generator(state); }
+		Move_piece_generator<N> generator;
+	};
+
+	template <typename Generator, unsigned N>
+	void measure(const char* name, unsigned long long iterations)
+	{
+		Simulated_annealing<N_queens<N>, Generator, Energy_evaluation<N>, Linear_schedule> sa(Generator(),
+				Energy_evaluation<N>(), Linear_schedule{iterations});
+		std::mt19937 re(N);
+		const auto start_state = random_queens_configuration<N>(re);
+		const auto start = std::chrono::steady_clock::now();
+		const auto result = sa(start_state);
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		std::cout << "N = " << N << ", " << name << ": " << static_cast<unsigned long long>(sa.iterations() / duration.count())
+				<< " iterations/s, conflicts " << result.conflicts() << std::endl;
+	}
+
+	template <unsigned N>
+	void compare(unsigned long long iterations)
+	{
+		measure<Move_piece_generator<N>, N>("moves", iterations);
+		measure<Successor_generator<N>, N>("successors", iterations);
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned long long iterations = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	std::cout << "Iterations: " << iterations << "\n";
+	compare<8>(iterations);
+	compare<1000>(iterations);
+}
@@ -0,0 +1,251 @@
+#ifndef AI_SEARCHING_SELECTION_HPP_
+#define AI_SEARCHING_SELECTION_HPP_
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * Selection policies of the genetic algorithms. A policy is prepared once per generation from the population,
+ * a vector of (individual, fitness) pairs where a lower fitness is better, and the number of picks the generation
+ * will make; then every pick costs O(1):
+ *
+ *	template <typename Population, typename Random_engine>
+ *	void prepare(const Population& population, std::size_t num_picks, Random_engine& re);
+ *	template <typename Random_engine>
+ *	std::size_t operator()(std::size_t pick, Random_engine& re) const;
+ *
+ * operator() returns the index of the selected individual; pick is the number of the pick in the generation,
+ * in [0, num_picks), and picks can be made by several threads at the same time.
+ */
+
+namespace detail
+{
+
+	/**
+	 * Weight of an individual in the fitness-proportional schemes, the fitness must not be negative
+	 */
+	inline double selection_weight(float fitness) noexcept
+	{
+		return 1.0 / (1.0 + fitness);
+	}
+
+}
+
+/**
+ * @brief Rank-based selection: the rank of the selected individual follows a geometric distribution
+ *
+ * Individuals aren't moved, small (fitness, index) keys are. Only the ranks covering all but one in a million
+ * of the picks are sorted, the rare picks beyond them select an individual of the unsorted tail.
+ */
+class Rank_selection
+{
+public:
+	/**
+	 * @param select_factor parameter of the geometric distribution, the higher the stronger the selection
+	 * @throw std::invalid_argument if select_factor isn't positive
+	 */
+	explicit Rank_selection(float select_factor = 0.05f)
+	// The sorted ranks of a very weak selection are capped, no population is that large
+	: log_complement_(std::log1p(-static_cast<double>(std::min(positive(select_factor), 0.999f)))),
+			sorted_ranks_(static_cast<std::size_t>(std::min(std::ceil(std::log(1e-6) / log_complement_),
+					static_cast<double>(std::numeric_limits<std::uint32_t>::max()))))
+	{}
+	template <typename Population, typename Random_engine>
+	void prepare(const Population& population, std::size_t, Random_engine&)
+	{
+		keys_.resize(population.size());
+		for (std::size_t i = 0; i < population.size(); ++i)
+		{
+			keys_[i] = Key{population[i].second, i};
+		}
+		std::partial_sort(keys_.begin(), keys_.begin() + std::min(sorted_ranks_, keys_.size()), keys_.end());
+		// Probability that an untruncated geometric variable is a valid rank
+		mass_ = -std::expm1(log_complement_ * keys_.size());
+	}
+	/**
+	 * Inverts the distribution function of the geometric distribution truncated to the population
+	 */
+	template <typename Random_engine>
+	std::size_t operator()(std::size_t, Random_engine& re) const
+	{
+		std::uniform_real_distribution<double> d(0, mass_);
+		const auto rank = static_cast<std::size_t>(std::log1p(-d(re)) / log_complement_);
+		return keys_[std::min(rank, keys_.size() - 1)].index;
+	}
+private:
+	static float positive(float select_factor)
+	{
+		if (!(select_factor > 0))
+		{
+			throw std::invalid_argument("Rank_selection needs a positive select factor");
+		}
+		return select_factor;
+	}
+	struct Key
+	{
+		bool operator<(const Key& other) const noexcept { return fitness < other.fitness; }
+		float fitness;
+		std::size_t index;
+	};
+
+	double log_complement_;
+	std::size_t sorted_ranks_;
+	double mass_ = 0;
+	std::vector<Key> keys_;
+};
+
+/**
+ * @brief k-tournament selection: the best of k individuals chosen uniformly
+ */
+class Tournament_selection
+{
+public:
+	explicit Tournament_selection(unsigned k = 2) : k_(std::max(1u, k)) {}
+	template <typename Population, typename Random_engine>
+	void prepare(const Population& population, std::size_t, Random_engine&)
+	{
+		fitness_.resize(population.size());
+		for (std::size_t i = 0; i < population.size(); ++i)
+		{
+			fitness_[i] = population[i].second;
+		}
+	}
+	template <typename Random_engine>
+	std::size_t operator()(std::size_t, Random_engine& re) const
+	{
+		std::uniform_int_distribution<std::size_t> d(0, fitness_.size() - 1);
+		std::size_t best = d(re);
+		for (unsigned i = 1; i < k_; ++i)
+		{
+			const std::size_t challenger = d(re);
+			if (fitness_[challenger] < fitness_[best])
+			{
+				best = challenger;
+			}
+		}
+		return best;
+	}
+private:
+	unsigned k_;
+	// Copied from the population, so that the tournaments read contiguous memory
+	std::vector<float> fitness_;
+};
+
+/**
+ * @brief Fitness-proportional (roulette wheel) selection with Walker's alias method
+ *
+ * The weight of an individual is 1 / (1 + fitness). The alias table is built in O(n) with Vose's algorithm,
+ * then a pick takes one uniform integer and one uniform real.
+ */
+class Alias_selection
+{
+public:
+	template <typename Population, typename Random_engine>
+	void prepare(const Population& population, std::size_t, Random_engine&)
+	{
+		const std::size_t n = population.size();
+		probability_.resize(n);
+		alias_.resize(n);
+		small_.clear();
+		large_.clear();
+		small_.reserve(n);
+		large_.reserve(n);
+		double total = 0;
+		for (const auto& individual : population)
+		{
+			total += detail::selection_weight(individual.second);
+		}
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			probability_[i] = detail::selection_weight(population[i].second) * n / total;
+			(probability_[i] < 1 ? small_ : large_).push_back(i);
+		}
+		while (!small_.empty() && !large_.empty())
+		{
+			const std::size_t less = small_.back();
+			const std::size_t more = large_.back();
+			small_.pop_back();
+			large_.pop_back();
+			alias_[less] = more;
+			probability_[more] -= 1 - probability_[less];
+			(probability_[more] < 1 ? small_ : large_).push_back(more);
+		}
+		// Left over because of rounding errors, their probability is 1
+		for (auto i : small_)
+		{
+			probability_[i] = 1;
+		}
+		for (auto i : large_)
+		{
+			probability_[i] = 1;
+		}
+	}
+	template <typename Random_engine>
+	std::size_t operator()(std::size_t, Random_engine& re) const
+	{
+		std::uniform_int_distribution<std::size_t> column(0, probability_.size() - 1);
+		std::uniform_real_distribution<double> coin(0, 1);
+		const std::size_t i = column(re);
+		return coin(re) < probability_[i] ? i : alias_[i];
+	}
+private:
+	std::vector<double> probability_;
+	std::vector<std::size_t> alias_;
+	// Work lists of the construction, kept to reuse their memory
+	std::vector<std::size_t> small_;
+	std::vector<std::size_t> large_;
+};
+
+/**
+ * @brief Stochastic universal sampling
+ *
+ * Fitness-proportional like Alias_selection, with weights 1 / (1 + fitness), but all the picks of a generation
+ * are made at once with equally spaced pointers from a single random offset: an individual is picked a number
+ * of times within one of its expected number, which keeps the spread of the roulette wheel low.
+ * The picks are shuffled, then pick number i returns the i-th one.
+ */
+class Sus_selection
+{
+public:
+	template <typename Population, typename Random_engine>
+	void prepare(const Population& population, std::size_t num_picks, Random_engine& re)
+	{
+		picks_.resize(std::max<std::size_t>(1, num_picks));
+		double total = 0;
+		for (const auto& individual : population)
+		{
+			total += detail::selection_weight(individual.second);
+		}
+		const double step = total / picks_.size();
+		double pointer = std::uniform_real_distribution<double>(0, step)(re);
+		double cumulative = 0;
+		std::size_t individual = 0;
+		for (auto& pick : picks_)
+		{
+			while (individual + 1 < population.size() &&
+					cumulative + detail::selection_weight(population[individual].second) <= pointer)
+			{
+				cumulative += detail::selection_weight(population[individual].second);
+				++individual;
+			}
+			pick = individual;
+			pointer += step;
+		}
+		std::shuffle(picks_.begin(), picks_.end(), re);
+	}
+	template <typename Random_engine>
+	std::size_t operator()(std::size_t pick, Random_engine&) const
+	{
+		return picks_[pick % picks_.size()];
+	}
+private:
+	std::vector<std::size_t> picks_;
+};
+
+#endif
@@ -2,20 +2,193 @@
 #define AI_SEARCHING_SIMULATED_ANNEALING_HPP_
 
 #include <limits>
-#include <chrono>
 #include <utility>
 #include <random>
 #include <cmath>
+#include <type_traits>
+#include <cstdint>
+#include "Random_streams.hpp"
+
+namespace detail
+{
+
+	/**
+	 * Whether the generator proposes moves instead of whole successors, with the energy giving their delta:
+	 *
+	 *	Move generator.propose(const State&);
+	 *	void generator.apply(State&, Move&);
+	 *	float energy.delta(const State&, const Move&);
+	 */
+	template <typename State, typename Generator, typename Energy, typename = void>
+	struct Has_move_protocol : std::false_type {};
+
+	template <typename State, typename Generator, typename Energy>
+	struct Has_move_protocol<State, Generator, Energy, decltype(void(std::declval<Energy&>().delta(
+			std::declval<const State&>(), std::declval<Generator&>().propose(std::declval<const State&>()))))>
+	: std::true_type {};
+
+	/**
+	 * Moves of a generator following the move protocol
+	 */
+	template <typename State, typename Generator, typename Energy>
+	class Proposed_moves
+	{
+	public:
+		typedef decltype(std::declval<Generator&>().propose(std::declval<const State&>())) Move;
+
+		Proposed_moves(Generator& generator, Energy& energy, const State&) : generator_(generator), energy_(energy) {}
+		Move propose(const State& state) { return generator_.propose(state); }
+		float delta(const State& state, const Move& move) { return energy_.delta(state, move); }
+		void apply(State& state, Move& move) { generator_.apply(state, move); }
+	private:
+		Generator& generator_;
+		Energy& energy_;
+	};
+
+	/**
+	 * Adapter turning a generator of whole successors into moves: a move is a successor along with its energy
+	 */
+	template <typename State, typename Generator, typename Energy>
+	class Successor_moves
+	{
+	public:
+		struct Move
+		{
+			State successor;
+			float energy;
+		};
+
+		Successor_moves(Generator& generator, Energy& energy, const State& start)
+		: generator_(generator), energy_(energy), current_e_(energy(start))
+		{}
+		Move propose(const State& state)
+		{
+			Move move{generator_(state), 0};
+			move.energy = energy_(move.successor);
+			return move;
+		}
+		float delta(const State&, const Move& move) const { return move.energy - current_e_; }
+		void apply(State& state, Move& move)
+		{
+			state = std::move(move.successor);
+			current_e_ = move.energy;
+		}
+	private:
+		Generator& generator_;
+		Energy& energy_;
+		float current_e_;
+	};
+
+	/**
+	 * Whether the generator can be reseeded with generator.seed(value), so that its choices depend on the seed
+	 * of the algorithm and its copies make different choices
+	 */
+	template <typename Generator, typename = void>
+	struct Has_seed : std::false_type {};
+
+	template <typename Generator>
+	struct Has_seed<Generator, decltype(void(std::declval<Generator&>().seed(0u)))> : std::true_type {};
+
+	template <typename Generator>
+	void seed_generator(Generator& generator, unsigned seed, std::true_type)
+	{
+		generator.seed(seed);
+	}
+
+	template <typename Generator>
+	void seed_generator(Generator&, unsigned, std::false_type)
+	{}
+
+	template <typename Generator>
+	void seed_generator(Generator& generator, unsigned seed)
+	{
+		seed_generator(generator, seed, Has_seed<Generator>());
+	}
+
+	/**
+	 * Moves chosen by the generator for Simulated_annealing
+	 */
+	template <typename State, typename Generator, typename Energy>
+	using Annealing_moves = typename std::conditional<Has_move_protocol<State, Generator, Energy>::value,
+			Proposed_moves<State, Generator, Energy>,
+			Successor_moves<State, Generator, Energy>>::type;
+
+	/**
+	 * Walk of a state through the state space at decreasing temperatures, keeping track of the best state.
+	 * The best state is copied from the current one only when an accepted move makes it worse.
+	 */
+	template <typename State, typename Generator, typename Energy, typename Engine>
+	class Annealing_walk
+	{
+	public:
+		Annealing_walk(State start, Generator& generator, Energy& energy, const Engine& engine)
+		: moves_(generator, energy, start),
+				engine_(engine),
+				current_(std::move(start)),
+				current_e_(energy(current_)),
+				best_e_(current_e_)
+		{}
+		/**
+		 * @brief Proposes a move and accepts it with the Metropolis criterion
+		 */
+		void step(float temp)
+		{
+			auto move = moves_.propose(current_);
+			const float delta_e = moves_.delta(current_, move);
+			if (delta_e < 0 || std::uniform_real_distribution<float>(0, 1)(engine_) < std::exp(-delta_e / temp))
+			{
+				current_e_ += delta_e;
+				if (current_e_ <= best_e_)
+				{
+					best_e_ = current_e_;
+					current_is_best_ = true;
+				}
+				else if (current_is_best_)
+				{
+					best_ = current_;
+					current_is_best_ = false;
+				}
+				moves_.apply(current_, move);
+			}
+		}
+		float energy() const noexcept { return current_e_; }
+		float best_energy() const noexcept { return best_e_; }
+		State best() &&
+		{
+			if (current_is_best_)
+			{
+				return std::move(current_);
+			}
+			return std::move(best_);
+		}
+	private:
+		Annealing_moves<State, Generator, Energy> moves_;
+		Engine engine_;
+		State current_;
+		float current_e_;
+		State best_;
+		float best_e_;
+		bool current_is_best_ = true;
+	};
+
+}
 
 /**
  * @brief Generic simulated annealing algorithm
  *
+ * If the generator proposes moves (see detail::Has_move_protocol), a state is changed only when a move
+ * is accepted and its energy is updated with the delta of the move; otherwise every iteration creates
+ * a whole successor and evaluates it. In both cases the best state is copied only when the search is
+ * about to leave it.
+ *
  * @tparam State represents the states of the problem
- * @tparam Generator callable returning a random successor of a state
+ * @tparam Generator callable returning a random successor of a state, or proposing moves
  * @tparam Energy callable returning the estimated energy of a state (the lower the better)
  * @tparam Schedule callable mapping time (intended as number of iterations) to temperature
+ * @tparam Engine random engine constructible from a seed and a stream id, deciding whether moves are accepted;
+ * a generator with a seed(unsigned) member is reseeded from it at every run
  */
-template <typename State, typename Generator, typename Energy, typename Schedule>
+template <typename State, typename Generator, typename Energy, typename Schedule, typename Engine = Philox4x32>
 class Simulated_annealing
 {
 public:
@@ -23,66 +196,54 @@ public:
 	Simulated_annealing(const Generator& generator = Generator(),
 			const Energy& energy = Energy(),
 			const Schedule& schedule = Schedule())
-	: generator_(generator), energy_(energy), schedule_(schedule)
+	: generator_(generator), energy_(energy), schedule_(schedule), seed_(detail::clock_seed())
 	{}
-    State operator()(State start);
+	State operator()(State start);
+	/**
+	 * @brief Sets the seed of the following runs
+	 */
+	void seed(std::uint64_t value) noexcept
+	{
+		seed_ = value;
+		runs_ = 0;
+	}
+	/**
+	 * @brief Stops the following runs as soon as the energy is at most value; by default runs end when the schedule does
+	 */
+	void target(float value) noexcept { target_ = value; }
+	/**
+	 * @return Number of iterations of the last run
+	 */
+	unsigned long long iterations() const noexcept { return iterations_; }
 private:
-    Generator generator_;
-    Energy energy_;
-    Schedule schedule_;
+	Generator generator_;
+	Energy energy_;
+	Schedule schedule_;
+	std::uint64_t seed_;
+	std::uint64_t runs_ = 0;
+	float target_ = std::numeric_limits<float>::lowest();
+	unsigned long long iterations_ = 0;
 };
 
-namespace detail
-{
-
-    template <typename State>
-    inline void update_current(State& current, float& current_e, const State& next, float next_e)
-    {
-        current = std::move(next);
-        current_e = next_e;
-    }
-
-    inline bool random_check(float p)
-    {
-    	static thread_local std::mt19937 re(std::chrono::system_clock::now().time_since_epoch().count());
-        static thread_local std::uniform_real_distribution<float> dist(0, 1);
-        return p < dist(re);
-    }
-
-}
-
-template <typename State, typename Generator, typename Energy, typename Schedule>
-State Simulated_annealing<State, Generator, Energy, Schedule>::operator()(State start)
+template <typename State, typename Generator, typename Energy, typename Schedule, typename Engine>
+State Simulated_annealing<State, Generator, Energy, Schedule, Engine>::operator()(State start)
 {
-    State current = std::move(start);
-    float current_e = energy_(current);
-    State best;
-    float best_e = std::numeric_limits<float>::max();
-    for (unsigned long long t = 1; t < std::numeric_limits<decltype(t)>::max(); ++t)
-    {
-        const float temp = schedule_(t);
-        if (temp == 0)
+	const std::uint64_t run_seed = detail::run_seed(seed_, runs_++);
+	detail::seed_generator(generator_, Engine(run_seed, 1)());
+	detail::Annealing_walk<State, Generator, Energy, Engine> walk(std::move(start), generator_, energy_,
+			Engine(run_seed, 0));
+	unsigned long long t = 1;
+	for (; t < std::numeric_limits<decltype(t)>::max() && walk.energy() > target_; ++t)
+	{
+		const float temp = schedule_(t);
+		if (temp == 0)
 		{
-            return best;
+			break;
 		}
-        const auto next = generator_(current);
-        const float next_e = energy_(next);
-        const float delta_e = current_e - next_e;
-        if (delta_e > 0)
-        {
-        	if (next_e < best_e)
-        	{
-        		best = next;
-        		best_e = next_e;
-        	}
-            detail::update_current(current, current_e, next, next_e);
-        }
-        else if (detail::random_check(std::exp(delta_e / temp)))
-        {
-        	detail::update_current(current, current_e, next, next_e);
-        }
-    }
-    return best;
+		walk.step(temp);
+	}
+	iterations_ = t - 1;
+	return std::move(walk).best();
 }
 
 #endif
@@ -0,0 +1,327 @@
+#ifndef AI_TASK_FUTURE_HPP_
+#define AI_TASK_FUTURE_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <new>
+#include <utility>
+#include <cstddef>
+#include <type_traits>
+
+namespace detail
+{
+
+	/**
+	 * Thread-local cache of memory blocks for objects of type T, so that objects created and destroyed
+	 * at a high rate don't go through the heap every time. A block can be released by a thread other
+	 * than the one which allocated it.
+	 */
+	template <typename T>
+	class Object_cache
+	{
+	public:
+		static void* allocate()
+		{
+			Cache& cache = local_cache();
+			if (cache.head != nullptr)
+			{
+				Block* block = cache.head;
+				cache.head = block->next;
+				--cache.size;
+				return block;
+			}
+			return ::operator new(block_size);
+		}
+		static void deallocate(void* p) noexcept
+		{
+			Cache& cache = local_cache();
+			if (cache.size == max_cached)
+			{
+				::operator delete(p);
+				return;
+			}
+			Block* block = static_cast<Block*>(p);
+			block->next = cache.head;
+			cache.head = block;
+			++cache.size;
+		}
+	private:
+		struct Block
+		{
+			Block* next;
+		};
+		struct Cache
+		{
+			~Cache()
+			{
+				while (head != nullptr)
+				{
+					Block* next = head->next;
+					::operator delete(head);
+					head = next;
+				}
+			}
+			Block* head = nullptr;
+			std::size_t size = 0;
+		};
+		static constexpr std::size_t block_size = sizeof(T) > sizeof(Block) ? sizeof(T) : sizeof(Block);
+		static constexpr std::size_t max_cached = 4096;
+		static Cache& local_cache() noexcept
+		{
+			static thread_local Cache cache;
+			return cache;
+		}
+	};
+
+	/**
+	 * State shared by a Task_promise and its Task_future
+	 */
+	template <typename T>
+	class Task_state
+	{
+	public:
+		static Task_state* create()
+		{
+			return new (Object_cache<Task_state>::allocate()) Task_state();
+		}
+		void add_reference() noexcept
+		{
+			references_.fetch_add(1, std::memory_order_relaxed);
+		}
+		void release() noexcept
+		{
+			if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				this->~Task_state();
+				Object_cache<Task_state>::deallocate(this);
+			}
+		}
+		template <typename... Args>
+		void set_value(Args&&... args)
+		{
+			new (&storage_) T(std::forward<Args>(args)...);
+			has_value_ = true;
+			make_ready();
+		}
+		void set_exception(std::exception_ptr exception)
+		{
+			exception_ = std::move(exception);
+			make_ready();
+		}
+		bool ready() const noexcept { return status_.load(std::memory_order_acquire) == ready_status; }
+		void wait()
+		{
+			if (ready())
+			{
+				return;
+			}
+			std::unique_lock<std::mutex> lock(mutex_);
+			int status = not_ready;
+			// Registering the waiter under the lock pairs with make_ready, which notifies under the same lock
+			if (status_.compare_exchange_strong(status, waiting, std::memory_order_acq_rel) || status == waiting)
+			{
+				cond_.wait(lock, [this]() { return ready(); });
+			}
+		}
+		T get()
+		{
+			wait();
+			if (exception_)
+			{
+				std::rethrow_exception(exception_);
+			}
+			return std::move(*reinterpret_cast<T*>(&storage_));
+		}
+	private:
+		static constexpr int not_ready = 0;
+		static constexpr int waiting = 1;
+		static constexpr int ready_status = 2;
+
+		Task_state() = default;
+		~Task_state()
+		{
+			if (has_value_)
+			{
+				reinterpret_cast<T*>(&storage_)->~T();
+			}
+		}
+		void make_ready()
+		{
+			if (status_.exchange(ready_status, std::memory_order_acq_rel) == waiting)
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				cond_.notify_all();
+			}
+		}
+
+		std::atomic<int> references_{1};
+		std::atomic<int> status_{not_ready};
+		bool has_value_ = false;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+		std::exception_ptr exception_;
+		std::mutex mutex_;
+		std::condition_variable cond_;
+	};
+
+	struct Task_void {};
+
+	template <typename T>
+	struct Task_value
+	{
+		typedef T type;
+	};
+
+	template <>
+	struct Task_value<void>
+	{
+		typedef Task_void type;
+	};
+
+}
+
+template <typename T> class Task_promise;
+
+/**
+ * @brief Result of a task submitted to a Thread_pool, a lighter alternative to std::future
+ *
+ * The shared state is recycled through a thread-local cache instead of being allocated for every task.
+ * Destroying a future doesn't wait for the task.
+ */
+template <typename T>
+class Task_future
+{
+	typedef typename detail::Task_value<T>::type Value;
+public:
+	Task_future() = default;
+	Task_future(Task_future&& other) noexcept : state_(other.state_) { other.state_ = nullptr; }
+	Task_future& operator=(Task_future&& other) noexcept
+	{
+		std::swap(state_, other.state_);
+		return *this;
+	}
+	Task_future(const Task_future&) = delete;
+	Task_future& operator=(const Task_future&) = delete;
+	~Task_future()
+	{
+		if (state_ != nullptr)
+		{
+			state_->release();
+		}
+	}
+	bool valid() const noexcept { return state_ != nullptr; }
+	/**
+	 * @return True if the result is available and get won't block
+	 */
+	bool ready() const noexcept { return state_->ready(); }
+	void wait() const { state_->wait(); }
+	/**
+	 * @brief Waits for the result and returns it, the future is no longer valid afterwards
+	 *
+	 * @throw the exception thrown by the task
+	 */
+	T get()
+	{
+		detail::Task_state<Value>* state = state_;
+		state_ = nullptr;
+		struct Release
+		{
+			~Release() { state->release(); }
+			detail::Task_state<Value>* state;
+		} release{state};
+		return static_cast<T>(state->get());
+	}
+private:
+	friend class Task_promise<T>;
+	explicit Task_future(detail::Task_state<Value>* state) noexcept : state_(state)
+	{
+		state_->add_reference();
+	}
+
+	detail::Task_state<Value>* state_ = nullptr;
+};
+
+/**
+ * @brief Producer side of a Task_future
+ *
+ * A promise destroyed without a result sets a std::future_error (broken_promise) on its future.
+ */
+template <typename T>
+class Task_promise
+{
+	typedef typename detail::Task_value<T>::type Value;
+public:
+	Task_promise() : state_(detail::Task_state<Value>::create()) {}
+	Task_promise(Task_promise&& other) noexcept : state_(other.state_), satisfied_(other.satisfied_)
+	{
+		other.state_ = nullptr;
+	}
+	Task_promise& operator=(Task_promise&& other) noexcept
+	{
+		std::swap(state_, other.state_);
+		std::swap(satisfied_, other.satisfied_);
+		return *this;
+	}
+	Task_promise(const Task_promise&) = delete;
+	Task_promise& operator=(const Task_promise&) = delete;
+	~Task_promise()
+	{
+		if (state_ != nullptr)
+		{
+			if (!satisfied_)
+			{
+				state_->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+			}
+			state_->release();
+		}
+	}
+	/**
+	 * @brief Returns the future bound to this promise
+	 */
+	Task_future<T> get_future() noexcept { return Task_future<T>(state_); }
+	template <typename... Args>
+	void set_value(Args&&... args)
+	{
+		satisfied_ = true;
+		state_->set_value(std::forward<Args>(args)...);
+	}
+	void set_exception(std::exception_ptr exception)
+	{
+		satisfied_ = true;
+		state_->set_exception(std::move(exception));
+	}
+	/**
+	 * @brief Calls f and stores its result or its exception
+	 */
+	template <typename Function>
+	void run(Function& f)
+	{
+		try
+		{
+			run_impl(f, std::is_void<T>());
+		}
+		catch (...)
+		{
+			set_exception(std::current_exception());
+		}
+	}
+private:
+	template <typename Function>
+	void run_impl(Function& f, std::true_type)
+	{
+		f();
+		set_value();
+	}
+	template <typename Function>
+	void run_impl(Function& f, std::false_type)
+	{
+		set_value(f());
+	}
+
+	detail::Task_state<Value>* state_;
+	bool satisfied_ = false;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/**
+	Distribution of the time to solution of annealing on N-queens boards: a single replica, independent
+	replicas at the same temperature (multi-start) and parallel tempering, which exchanges the replicas
+	between a ladder of temperatures. Each run stops at the first solution or after a maximum number of
+	iterations; the times are the minimum, median, 90th percentile and maximum over the solved runs.
+	Usage: Tempering_benchmark [runs] [replicas] [max iterations] [number of threads]
+ */
+
+#include "N_queens.hpp"
+#include "Parallel_tempering.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+
+	struct Settings
+	{
+		unsigned runs;
+		unsigned replicas;
+		unsigned long long max_iterations;
+		unsigned num_threads;
+	};
+
+	/**
+	 * Constant temperature of the coldest replica, until the maximum number of iterations
+	 */
+	struct Constant_schedule
+	{
+		float operator()(unsigned long long t) const
+		{
+			return t < max_iterations ? temperature : 0.0f;
+		}
+		float temperature;
+		unsigned long long max_iterations;
+	};
+
+	template <unsigned N>
+	void measure(const char* name, const Settings& settings, unsigned replicas, float temperature_ratio)
+	{
+		std::vector<double> times;
+		for (unsigned i = 0; i < settings.runs; ++i)
+		{
+			Parallel_tempering<N_queens<N>, Move_piece_generator<N>, Energy_evaluation<N>, Constant_schedule> pt(
+					Move_piece_generator<N>(), Energy_evaluation<N>(), Constant_schedule{0.2f, settings.max_iterations},
+					replicas, temperature_ratio);
+			const auto start = std::chrono::steady_clock::now();
+			pt(random_queens_configuration<N>(), settings.num_threads);
+			const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+			if (pt.solved())
+			{
+				times.push_back(duration.count());
+			}
+		}
+		std::sort(times.begin(), times.end());
+		std::cout << "N = " << N << ", " << std::setw(12) << std::left << name << std::right << " solved "
+				<< times.size() << "/" << settings.runs;
+		if (!times.empty())
+		{
+			std::cout << std::fixed << std::setprecision(1) << ", ms: min " << times.front()
+					<< ", median " << times[times.size() / 2]
+					<< ", p90 " << times[std::min(times.size() - 1, times.size() * 9 / 10)]
+					<< ", max " << times.back();
+		}
+		std::cout << std::endl;
+	}
+
+	template <unsigned N>
+	void compare(const Settings& settings)
+	{
+		measure<N>("single", settings, 1, 1.0f);
+		measure<N>("multi-start", settings, settings.replicas, 1.0f);
+		measure<N>("tempering", settings, settings.replicas, 2.0f);
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	Settings settings;
+	settings.runs = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20;
+	settings.replicas = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 4;
+	settings.max_iterations = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+	settings.num_threads = (argc > 4) ? std::strtoul(argv[4], nullptr, 10) : std::thread::hardware_concurrency();
+	std::cout << "Runs: " << settings.runs << ", replicas: " << settings.replicas << ", max iterations: "
+			<< settings.max_iterations << ", threads: " << settings.num_threads << "\n";
+	compare<16>(settings);
+	compare<24>(settings);
+}
@@ -14,7 +14,18 @@
 #include <deque>
 #include <type_traits>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <algorithm>
+#include <initializer_list>
 #include "Thread_joiner.hpp"
+#include "Task_future.hpp"
+#include "../../concurrency/Mpmc_queue.hpp"
+#include "Thread_pool_stats.hpp"
+#include "Cpu_topology.hpp"
 
 template <typename T>
 class Threadsafe_queue
@@ -160,175 +171,751 @@ bool Threadsafe_queue<T>::try_pop(T& value)
 	return old_head != nullptr;
 }
 
+/**
+ * Move-only callable taking no arguments. Callables of up to inline_size bytes which can be moved without
+ * throwing are stored inline, larger ones on the heap.
+ */
 class Function_wrapper
 {
-    struct Impl_base
-    {
-        virtual void call() = 0;
-        virtual ~Impl_base() {}
-    };
-    template <typename F>
-    struct Impl_type: Impl_base
-    {
-        F f;
-        Impl_type(F&& f_): f(std::move(f_)) {}
-        void call() { f(); }
-    };
-    std::unique_ptr<Impl_base> impl_;
 public:
-    Function_wrapper() = default;
-    template <typename F>
-    Function_wrapper(F&& f) : impl_(new Impl_type<F>(std::move(f))) {}
-    Function_wrapper(Function_wrapper&& other) : impl_(std::move(other.impl_)) {}
-    void operator()() { impl_->call(); }
-    Function_wrapper& operator=(Function_wrapper&& other)
-    {
-        impl_ = std::move(other.impl_);
-        return *this;
-    }
-    Function_wrapper(const Function_wrapper&) = delete;
-    Function_wrapper(Function_wrapper&) = delete;
-    Function_wrapper& operator=(const Function_wrapper&) = delete;
+	static constexpr std::size_t inline_size = 48;
+
+	Function_wrapper() = default;
+	template <typename F, typename = typename std::enable_if<
+			!std::is_same<typename std::decay<F>::type, Function_wrapper>::value>::type>
+	Function_wrapper(F&& f)
+	{
+		typedef typename std::decay<F>::type Callable;
+		construct<Callable>(std::forward<F>(f), std::integral_constant<bool, fits_inline<Callable>()>());
+	}
+	Function_wrapper(Function_wrapper&& other) noexcept
+	{
+		move_from(other);
+	}
+	Function_wrapper& operator=(Function_wrapper&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			move_from(other);
+		}
+		return *this;
+	}
+	Function_wrapper(const Function_wrapper&) = delete;
+	Function_wrapper& operator=(const Function_wrapper&) = delete;
+	~Function_wrapper()
+	{
+		reset();
+	}
+	void operator()() { ops_->call(&storage_); }
+	explicit operator bool() const noexcept { return ops_ != nullptr; }
+private:
+	typedef std::aligned_storage<inline_size, alignof(std::max_align_t)>::type Storage;
+	struct Ops
+	{
+		void (*call)(void*);
+		// Move-constructs the callable into the destination and destroys the source
+		void (*relocate)(void*, void*) noexcept;
+		void (*destroy)(void*) noexcept;
+	};
+	template <typename F>
+	static constexpr bool fits_inline()
+	{
+		return sizeof(F) <= inline_size && alignof(F) <= alignof(std::max_align_t) &&
+				std::is_nothrow_move_constructible<F>::value;
+	}
+	template <typename F>
+	struct Inline_ops
+	{
+		static void call(void* p) { (*static_cast<F*>(p))(); }
+		static void relocate(void* from, void* to) noexcept
+		{
+			new (to) F(std::move(*static_cast<F*>(from)));
+			static_cast<F*>(from)->~F();
+		}
+		static void destroy(void* p) noexcept { static_cast<F*>(p)->~F(); }
+		static constexpr Ops ops = {&call, &relocate, &destroy};
+	};
+	template <typename F>
+	struct Heap_ops
+	{
+		static void call(void* p) { (**static_cast<F**>(p))(); }
+		static void relocate(void* from, void* to) noexcept { *static_cast<F**>(to) = *static_cast<F**>(from); }
+		static void destroy(void* p) noexcept { delete *static_cast<F**>(p); }
+		static constexpr Ops ops = {&call, &relocate, &destroy};
+	};
+	template <typename F, typename Arg>
+	void construct(Arg&& f, std::true_type)
+	{
+		new (&storage_) F(std::forward<Arg>(f));
+		ops_ = &Inline_ops<F>::ops;
+	}
+	template <typename F, typename Arg>
+	void construct(Arg&& f, std::false_type)
+	{
+		*reinterpret_cast<F**>(&storage_) = new F(std::forward<Arg>(f));
+		ops_ = &Heap_ops<F>::ops;
+	}
+	void move_from(Function_wrapper& other) noexcept
+	{
+		if (other.ops_ != nullptr)
+		{
+			other.ops_->relocate(&other.storage_, &storage_);
+			ops_ = other.ops_;
+			other.ops_ = nullptr;
+		}
+	}
+	void reset() noexcept
+	{
+		if (ops_ != nullptr)
+		{
+			ops_->destroy(&storage_);
+			ops_ = nullptr;
+		}
+	}
+
+	Storage storage_;
+	const Ops* ops_ = nullptr;
 };
 
+template <typename F>
+constexpr Function_wrapper::Ops Function_wrapper::Inline_ops<F>::ops;
+
+template <typename F>
+constexpr Function_wrapper::Ops Function_wrapper::Heap_ops<F>::ops;
+
+/**
+ * Lock-free work-stealing deque (Chase and Lev, with the memory orderings of Le et al. for weak memory models)
+ *
+ * Only the owner thread can call push and try_pop: they don't use any atomic read-modify-write operation
+ * except when they compete with thieves for the last task. Other threads call try_steal, which takes
+ * the oldest task with a compare-and-swap. The buffer grows when full; old buffers are kept until
+ * destruction because a thief may still be reading from them.
+ * Slots can only hold pointers, so tasks are moved into nodes recycled by the thread-local object cache.
+ */
 class Work_stealing_queue
 {
 	typedef Function_wrapper Data_type;
+	struct Node
+	{
+		Data_type data;
+	};
+	typedef Node* Task;
+	struct Buffer
+	{
+		explicit Buffer(std::int64_t capacity) : mask(capacity - 1), slots(new std::atomic<Task>[capacity]) {}
+		std::int64_t capacity() const noexcept { return mask + 1; }
+		Task get(std::int64_t i) const noexcept { return slots[i & mask].load(std::memory_order_relaxed); }
+		void put(std::int64_t i, Task task) noexcept { slots[i & mask].store(task, std::memory_order_relaxed); }
+		const std::int64_t mask;
+		const std::unique_ptr<std::atomic<Task>[]> slots;
+	};
 public:
-	Work_stealing_queue()
-	{}
+	/**
+	 * @param capacity initial size of the buffer, must be a power of two
+	 */
+	explicit Work_stealing_queue(std::int64_t capacity = 256)
+	: top_(0), bottom_(0)
+	{
+		buffers_.push_back(std::make_unique<Buffer>(capacity));
+		buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+	}
 	Work_stealing_queue(const Work_stealing_queue& other) = delete;
 	Work_stealing_queue& operator=(const Work_stealing_queue& other) = delete;
+	~Work_stealing_queue()
+	{
+		const Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+		for (auto i = top_.load(std::memory_order_relaxed); i < bottom_.load(std::memory_order_relaxed); ++i)
+		{
+			destroy(buffer->get(i));
+		}
+	}
 	void push(Data_type data)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
-		queue_.push_front(std::move(data));
+		const auto bottom = bottom_.load(std::memory_order_relaxed);
+		const auto top = top_.load(std::memory_order_acquire);
+		Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+		if (bottom - top > buffer->mask)
+		{
+			buffer = grow(buffer, top, bottom);
+		}
+		buffer->put(bottom, new (detail::Object_cache<Node>::allocate()) Node{std::move(data)});
+		bottom_.store(bottom + 1, std::memory_order_release);
 	}
 	bool empty() const
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
-		return queue_.empty();
+		return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+	}
+	/**
+	 * @return Number of tasks in the queue, exact only if called by the owner while there are no thieves
+	 */
+	std::size_t size() const
+	{
+		const auto bottom = bottom_.load(std::memory_order_relaxed);
+		const auto top = top_.load(std::memory_order_relaxed);
+		return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
 	}
 	bool try_pop(Data_type& res)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
-		if (queue_.empty())
+		// The owner sees its own bottom and at most an old top, so an empty queue is always detected
+		if (empty())
+		{
+			return false;
+		}
+		const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+		const Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+		bottom_.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto top = top_.load(std::memory_order_relaxed);
+		if (top > bottom)
 		{
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
 			return false;
 		}
-		res = std::move(queue_.front());
-		queue_.pop_front();
+		const Task task = buffer->get(bottom);
+		if (top == bottom)
+		{
+			// Last task: race against the thieves
+			const bool won = top_.compare_exchange_strong(top,
+					top + 1,
+					std::memory_order_seq_cst,
+					std::memory_order_relaxed);
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			if (!won)
+			{
+				return false;
+			}
+		}
+		res = std::move(task->data);
+		destroy(task);
 		return true;
 	}
 	bool try_steal(Data_type& res)
 	{
-		std::lock_guard<std::mutex> lock(mutex_);
-		if (queue_.empty())
+		if (empty())
 		{
 			return false;
 		}
-		res = std::move(queue_.back());
-		queue_.pop_back();
+		auto top = top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto bottom = bottom_.load(std::memory_order_acquire);
+		if (top >= bottom)
+		{
+			return false;
+		}
+		const Task task = buffer_.load(std::memory_order_acquire)->get(top);
+		if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return false;
+		}
+		res = std::move(task->data);
+		destroy(task);
 		return true;
 	}
 private:
-	std::deque<Data_type> queue_;
-	mutable std::mutex mutex_;
+	static void destroy(Task task) noexcept
+	{
+		task->~Node();
+		detail::Object_cache<Node>::deallocate(task);
+	}
+	Buffer* grow(const Buffer* buffer, std::int64_t top, std::int64_t bottom)
+	{
+		buffers_.push_back(std::make_unique<Buffer>(buffer->capacity() * 2));
+		Buffer* new_buffer = buffers_.back().get();
+		for (auto i = top; i < bottom; ++i)
+		{
+			new_buffer->put(i, buffer->get(i));
+		}
+		buffer_.store(new_buffer, std::memory_order_release);
+		return new_buffer;
+	}
+
+	std::atomic<std::int64_t> top_;
+	std::atomic<std::int64_t> bottom_;
+	std::atomic<Buffer*> buffer_;
+	// Written only by the owner
+	std::vector<std::unique_ptr<Buffer>> buffers_;
 };
 
+/**
+ * Priority levels of the tasks of a Thread_pool, from the most urgent
+ */
+enum class Task_priority { high, normal, low };
+
 class Thread_pool
 {
 public:
-	Thread_pool(unsigned num_threads = std::thread::hardware_concurrency()) : done_(false), joiner_(threads_)
+	static constexpr unsigned num_priorities = 3;
+
+
+	/**
+	 * @param queue_capacity maximum number of tasks of each priority submitted from threads outside the pool
+	 * and not yet started; when the queue is full the submitting thread runs pending tasks itself until there's room
+	 * @param pin_workers bind every worker to a CPU, filling the cores that share a cache first; workers then
+	 * steal from the workers closest to them in the cache hierarchy before the others
+	 */
+	Thread_pool(unsigned num_threads = std::thread::hardware_concurrency(),
+			std::size_t queue_capacity = 1024,
+			bool pin_workers = false)
+	: done_(false),
+			counters_(num_threads),
+			start_time_(Clock::now()),
+			joiner_(threads_)
     {
     	try
     	{
-			for (unsigned i = 0; i < num_threads; ++i)
+			place_workers(num_threads, pin_workers);
+			for (unsigned level = 0; level < num_priorities; ++level)
+			{
+				pool_work_queues_.push_back(std::make_unique<Mpmc_queue<Function_wrapper>>(queue_capacity));
+			}
+			// Workers steal from each other, so all the queues must exist before the first thread starts
+			for (unsigned i = 0; i < num_threads * num_priorities; ++i)
 			{
 				queues_.push_back(std::make_unique<Work_stealing_queue>());
+			}
+			for (unsigned i = 0; i < num_threads; ++i)
+			{
 				threads_.push_back(std::thread(&Thread_pool::worker_thread, this, i));
 			}
     	}
     	catch (...)
     	{
 			done_ = true;
+			wake_all();
 			throw;
     	}
     }
     ~Thread_pool()
     {
         done_ = true;
+        wake_all();
     }
+    /**
+     * @param priority workers look for tasks of higher priority first, at every task boundary
+     */
     template <typename FunctionType>
-    std::future<typename std::result_of<FunctionType()>::type> submit(FunctionType f)
+    Task_future<typename std::result_of<FunctionType()>::type> submit(FunctionType f,
+    		Task_priority priority = Task_priority::normal)
     {
         typedef typename std::result_of<FunctionType()>::type result_type;
-        std::packaged_task<result_type()> task(std::move(f));
-        std::future<result_type> res(task.get_future());
-        if (local_work_queue_)
-        {
-        	local_work_queue_->push(std::move(task));
-        }
-        else
-        {
-        	pool_work_queue_.push(std::move(task));
-        }
+        Task_promise<result_type> promise;
+        auto res = promise.get_future();
+        push_task(Function_wrapper([promise = std::move(promise), f = std::move(f)]() mutable { promise.run(f); }),
+        		priority);
         return res;
     }
+    /**
+     * @brief Runs a task without providing a future for its completion
+     */
+    template <typename FunctionType>
+    void post(FunctionType f, Task_priority priority = Task_priority::normal)
+    {
+        push_task(Function_wrapper(std::move(f)), priority);
+    }
     void run_pending_task()
     {
-        Function_wrapper task;
-		if (pop_task_from_local_queue(task) ||
-			pop_task_from_pool_queue(task) ||
-			pop_task_from_other_thread_queue(task))
-		{
-        	task();
-        }
-        else
+        if (!try_run_pending_task())
         {
         	std::this_thread::yield();
         }
     }
+    /**
+     * @brief Takes a snapshot of the counters of the workers, which are updated while it's being taken
+     */
+    Thread_pool_stats stats() const;
 private:
+	typedef std::chrono::steady_clock Clock;
+	enum class Task_source { none, local, pool, stolen };
+	/**
+	 * Counters of a worker. Only the worker writes them, so they are updated without read-modify-write
+	 * operations; the padding keeps the counters of different workers in different cache lines
+	 */
+	struct Worker_counters
+	{
+		static void increase(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		}
+		std::atomic<std::uint64_t> local_tasks{0};
+		std::atomic<std::uint64_t> pool_tasks{0};
+		std::atomic<std::uint64_t> stolen_tasks{0};
+		std::atomic<std::uint64_t> failed_steals{0};
+		std::atomic<std::uint64_t> parks{0};
+		std::atomic<std::uint64_t> idle_ns{0};
+		std::atomic<std::uint64_t> max_queue_depth{0};
+		char padding[64];
+	};
+
+	/**
+	 * Number of queued tasks of high priority, padded to its own cache line. It's increased before a task
+	 * is pushed, so the high priority queues are never skipped while they hold a task
+	 */
+	struct Queued_tasks
+	{
+		char padding[64];
+		std::atomic<std::int64_t> count{0};
+	};
+
+	// Failed attempts to find a task before an idle worker starts yielding, and then parks
+	static constexpr unsigned idle_spins = 64;
+	static constexpr unsigned idle_yields = 16;
+	// Every fairness_interval tasks a thread looks for a task from the lowest priority and from the pool queues
+	// first, so tasks of low priority can't starve behind normal work, nor tasks submitted from outside the pool
+	// behind the local ones
+	static constexpr unsigned fairness_interval = 32;
+
+	bool is_worker() const noexcept { return local_pool_ == this; }
+	/**
+	 * Chooses the CPU of every worker and the order in which each worker visits the others to steal.
+	 * Unpinned workers can migrate, so they steal in round-robin order starting from their successor
+	 */
+	void place_workers(unsigned num_threads, bool pin_workers)
+	{
+		std::vector<Cpu_topology::Cpu> worker_cpus;
+		if (pin_workers)
+		{
+			const auto topology = Cpu_topology::detect();
+			const auto placement = topology.placement();
+			for (unsigned i = 0; i < num_threads; ++i)
+			{
+				const unsigned id = placement[i % placement.size()];
+				worker_cpus_.push_back(id);
+				worker_cpus.push_back(*std::find_if(topology.cpus().begin(),
+						topology.cpus().end(),
+						[id](const Cpu_topology::Cpu& cpu) { return cpu.id == id; }));
+			}
+		}
+		for (unsigned i = 0; i < num_threads; ++i)
+		{
+			std::vector<unsigned> victims;
+			for (unsigned j = 1; j < num_threads; ++j)
+			{
+				victims.push_back((i + j) % num_threads);
+			}
+			if (pin_workers)
+			{
+				std::stable_sort(victims.begin(), victims.end(), [&worker_cpus, i](unsigned lhs, unsigned rhs)
+						{
+							return Cpu_topology::distance(worker_cpus[i], worker_cpus[lhs]) <
+									Cpu_topology::distance(worker_cpus[i], worker_cpus[rhs]);
+						});
+			}
+			victims_.push_back(std::move(victims));
+		}
+	}
+	Work_stealing_queue& worker_queue(unsigned worker, unsigned level)
+	{
+		return *queues_[worker * num_priorities + level];
+	}
+	void push_task(Function_wrapper task, Task_priority priority)
+	{
+		const auto level = static_cast<unsigned>(priority);
+		if (priority == Task_priority::high)
+		{
+			queued_high_.count.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (is_worker())
+		{
+			auto& queue = worker_queue(index_, level);
+			queue.push(std::move(task));
+			auto& counters = counters_[index_];
+			const auto depth = queue.size();
+			if (depth > counters.max_queue_depth.load(std::memory_order_relaxed))
+			{
+				counters.max_queue_depth.store(depth, std::memory_order_relaxed);
+			}
+		}
+		else
+		{
+			while (!pool_work_queues_[level]->try_push(task))
+			{
+				wake_one();
+				run_pending_task();
+			}
+		}
+		wake_one();
+	}
+	/**
+	 * Takes a task of the highest priority available. Tasks of high priority are counted, so that looking
+	 * for them at every task boundary costs a single load while there are none; tasks of lower priorities
+	 * aren't, to keep read-modify-write operations on shared data off the path of fine-grained tasks.
+	 * A fair round never passes over a task of high priority
+	 */
+	Task_source pop_task(Function_wrapper& task)
+	{
+		const bool fair = pop_rounds_ + 1 >= fairness_interval;
+		if (queued_high_.count.load(std::memory_order_relaxed) > 0)
+		{
+			const auto source = pop_task(task, static_cast<unsigned>(Task_priority::high), fair);
+			if (source != Task_source::none)
+			{
+				queued_high_.count.fetch_sub(1, std::memory_order_relaxed);
+				// A fair round taken by a task of high priority is left to the next task
+				if (!fair)
+				{
+					++pop_rounds_;
+				}
+				return source;
+			}
+		}
+		const unsigned normal = static_cast<unsigned>(Task_priority::normal);
+		const unsigned low = static_cast<unsigned>(Task_priority::low);
+		for (const unsigned level : {fair ? low : normal, fair ? normal : low})
+		{
+			const auto source = pop_task(task, level, fair);
+			if (source != Task_source::none)
+			{
+				pop_rounds_ = fair ? 0 : pop_rounds_ + 1;
+				return source;
+			}
+		}
+		return Task_source::none;
+	}
+	Task_source pop_task(Function_wrapper& task, unsigned level, bool pool_first)
+	{
+		if (pool_first && pop_task_from_pool_queue(task, level))
+		{
+			return Task_source::pool;
+		}
+		if (pop_task_from_local_queue(task, level))
+		{
+			return Task_source::local;
+		}
+		if (!pool_first && pop_task_from_pool_queue(task, level))
+		{
+			return Task_source::pool;
+		}
+		if (pop_task_from_other_thread_queue(task, level))
+		{
+			return Task_source::stolen;
+		}
+		return Task_source::none;
+	}
+	void count_task(Task_source source)
+	{
+		if (!is_worker())
+		{
+			external_tasks_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		auto& counters = counters_[index_];
+		switch (source)
+		{
+		case Task_source::local:
+			Worker_counters::increase(counters.local_tasks);
+			break;
+		case Task_source::pool:
+			Worker_counters::increase(counters.pool_tasks);
+			break;
+		case Task_source::stolen:
+			Worker_counters::increase(counters.stolen_tasks);
+			break;
+		case Task_source::none:
+			break;
+		}
+	}
+	bool try_run_pending_task()
+	{
+		Function_wrapper task;
+		const auto source = pop_task(task);
+		if (source == Task_source::none)
+		{
+			return false;
+		}
+		count_task(source);
+		task();
+		return true;
+	}
 	void worker_thread(unsigned index)
 	{
 		index_ = index;
-		local_work_queue_ = queues_[index].get();
+		if (!worker_cpus_.empty())
+		{
+			pin_current_thread(worker_cpus_[index]);
+		}
+		local_pool_ = this;
+		auto& counters = counters_[index];
+		unsigned idle_rounds = 0;
+		Clock::time_point idle_start;
 		while (!done_)
 		{
-			run_pending_task();
+			Function_wrapper task;
+			const auto source = pop_task(task);
+			if (source != Task_source::none)
+			{
+				if (idle_rounds != 0)
+				{
+					const auto idle_time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - idle_start);
+					Worker_counters::increase(counters.idle_ns, idle_time.count());
+					idle_rounds = 0;
+				}
+				count_task(source);
+				task();
+			}
+			else if (idle_rounds == 0)
+			{
+				idle_start = Clock::now();
+				++idle_rounds;
+			}
+			else if (idle_rounds < idle_spins)
+			{
+				++idle_rounds;
+			}
+			else if (idle_rounds < idle_spins + idle_yields)
+			{
+				++idle_rounds;
+				std::this_thread::yield();
+			}
+			else
+			{
+				Worker_counters::increase(counters.parks);
+				park();
+				// Keep counting idle time until a task is found
+				idle_rounds = 1;
+			}
 		}
 	}
-	bool pop_task_from_local_queue(Function_wrapper& task)
+	bool has_pending_task()
 	{
-		return local_work_queue_ && local_work_queue_->try_pop(task);
+		for (const auto& queue : pool_work_queues_)
+		{
+			if (!queue->empty())
+			{
+				return true;
+			}
+		}
+		for (const auto& queue : queues_)
+		{
+			if (!queue->empty())
+			{
+				return true;
+			}
+		}
+		return false;
 	}
-	bool pop_task_from_pool_queue(Function_wrapper& task)
+	/**
+	 * Sleeps until a task is submitted. The worker announces itself in sleepers_ before checking the queues
+	 * for the last time, and submitters check sleepers_ after pushing: either the worker sees the task or
+	 * the submitter sees the worker.
+	 */
+	void park()
 	{
-		return pool_work_queue_.try_pop(task);
+		const auto epoch = wake_epoch_.load(std::memory_order_acquire);
+		sleepers_.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!has_pending_task() && !done_)
+		{
+			std::unique_lock<std::mutex> lock(park_mutex_);
+			park_cond_.wait(lock, [this, epoch]()
+					{
+						return wake_epoch_.load(std::memory_order_relaxed) != epoch || done_;
+					});
+		}
+		sleepers_.fetch_sub(1, std::memory_order_relaxed);
+	}
+	/**
+	 * Wakes a parked worker, if any. Costs a fence and a load when all the workers are busy
+	 */
+	void wake_one()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers_.load(std::memory_order_relaxed) != 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(park_mutex_);
+				wake_epoch_.fetch_add(1, std::memory_order_release);
+			}
+			park_cond_.notify_one();
+		}
+	}
+	void wake_all()
+	{
+		{
+			std::lock_guard<std::mutex> lock(park_mutex_);
+			wake_epoch_.fetch_add(1, std::memory_order_release);
+		}
+		park_cond_.notify_all();
+	}
+	bool pop_task_from_local_queue(Function_wrapper& task, unsigned level)
+	{
+		return is_worker() && worker_queue(index_, level).try_pop(task);
+	}
+	bool pop_task_from_pool_queue(Function_wrapper& task, unsigned level)
+	{
+		return pool_work_queues_[level]->try_pop(task);
 	}
-	bool pop_task_from_other_thread_queue(Function_wrapper& task)
+	bool pop_task_from_other_thread_queue(Function_wrapper& task, unsigned level)
 	{
-		for (unsigned i = 0; i < queues_.size(); ++i)
+		if (!is_worker())
 		{
-			unsigned index = (index_ + i + 1) % queues_.size();
-			if(queues_[index]->try_steal(task))
+			for (unsigned worker = 0; worker < victims_.size(); ++worker)
 			{
-			return true;
+				if (worker_queue(worker, level).try_steal(task))
+				{
+					return true;
+				}
 			}
+			return false;
 		}
+		for (auto victim : victims_[index_])
+		{
+			if (worker_queue(victim, level).try_steal(task))
+			{
+				return true;
+			}
+		}
+		Worker_counters::increase(counters_[index_].failed_steals);
 		return false;
 	}
     std::atomic_bool done_;
-    Threadsafe_queue<Function_wrapper> pool_work_queue_;
+    std::atomic<unsigned> sleepers_{0};
+    std::atomic<unsigned> wake_epoch_{0};
+    std::mutex park_mutex_;
+    std::condition_variable park_cond_;
+    // Tasks submitted from outside the pool, one queue per priority
+    std::vector<std::unique_ptr<Mpmc_queue<Function_wrapper>>> pool_work_queues_;
+	// Queues of the workers, num_priorities for each worker
 	std::vector<std::unique_ptr<Work_stealing_queue>> queues_;
+	Queued_tasks queued_high_;
+	std::vector<Worker_counters> counters_;
+	// CPU of every worker, empty if the workers aren't pinned
+	std::vector<unsigned> worker_cpus_;
+	// Queues visited by every worker when stealing, closest first
+	std::vector<std::vector<unsigned>> victims_;
+	std::atomic<std::uint64_t> external_tasks_{0};
+	const Clock::time_point start_time_;
     std::vector<std::thread> threads_;
     Thread_joiner joiner_;
-    static thread_local Work_stealing_queue* local_work_queue_;
+    // The pool whose worker is the current thread, the other thread-local members are valid only for that pool
+    static thread_local const Thread_pool* local_pool_;
 	static thread_local unsigned index_;
+	// Tasks taken by the current thread since its last fair round
+	static thread_local unsigned pop_rounds_;
 };
 
-thread_local Work_stealing_queue* Thread_pool::local_work_queue_ = nullptr;
+thread_local const Thread_pool* Thread_pool::local_pool_ = nullptr;
 thread_local unsigned Thread_pool::index_ = 0;
+thread_local unsigned Thread_pool::pop_rounds_ = 0;
+
+inline Thread_pool_stats Thread_pool::stats() const
+{
+	Thread_pool_stats stats;
+	stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time_);
+	for (const auto& counters : counters_)
+	{
+		Thread_pool_stats::Worker worker;
+		worker.local_tasks = counters.local_tasks.load(std::memory_order_relaxed);
+		worker.pool_tasks = counters.pool_tasks.load(std::memory_order_relaxed);
+		worker.stolen_tasks = counters.stolen_tasks.load(std::memory_order_relaxed);
+		worker.failed_steals = counters.failed_steals.load(std::memory_order_relaxed);
+		worker.parks = counters.parks.load(std::memory_order_relaxed);
+		worker.idle_time = std::chrono::nanoseconds(counters.idle_ns.load(std::memory_order_relaxed));
+		worker.max_queue_depth = counters.max_queue_depth.load(std::memory_order_relaxed);
+		stats.workers.push_back(worker);
+	}
+	stats.external_tasks = external_tasks_.load(std::memory_order_relaxed);
+	return stats;
+}
 
 #endif
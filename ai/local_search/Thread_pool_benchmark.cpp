@@ -0,0 +1,99 @@
+/**
+	Measures the throughput of Thread_pool with very fine-grained tasks.
+	Every task of a binary tree submits its two children from inside the pool, so almost all the work
+	goes through the workers' local queues and idle workers have to steal it.
+	Prints the counters of the workers, then measures the CPU time used by the idle pool and the latency
+	of waking it up with a new task.
+	Usage: Thread_pool_benchmark [tree depth] [number of threads] [repetitions]
+ */
+
+#include "Thread_pool.hpp"
+#include "../Heap_allocations.hpp"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+
+namespace
+{
+
+	void spawn(Thread_pool& pool, std::atomic<unsigned long>& counter, unsigned depth)
+	{
+		if (depth > 0)
+		{
+			pool.submit([&pool, &counter, depth]() { spawn(pool, counter, depth - 1); });
+			pool.submit([&pool, &counter, depth]() { spawn(pool, counter, depth - 1); });
+		}
+		counter.fetch_add(1, std::memory_order_release);
+	}
+
+	void measure_idle()
+	{
+		const auto idle_time = std::chrono::seconds(1);
+		const std::clock_t cpu_start = std::clock();
+		std::this_thread::sleep_for(idle_time);
+		const double cpu_time = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+		std::cout << "CPU usage of the idle pool: " << cpu_time * 100 / idle_time.count() << "% of a core\n";
+	}
+
+	void measure_wake_up(Thread_pool& pool, unsigned repetitions)
+	{
+		typedef std::chrono::steady_clock Clock;
+		long long total = 0;
+		long long worst = 0;
+		for (unsigned i = 0; i < repetitions; ++i)
+		{
+			// Give the workers time to go idle
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			const auto submitted = Clock::now();
+			const auto started = pool.submit([]() { return Clock::now(); }).get();
+			const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(started - submitted).count();
+			total += latency;
+			worst = std::max<long long>(worst, latency);
+		}
+		std::cout << "Wake-up latency: " << total / std::max(1u, repetitions) << " microseconds on average, "
+				<< worst << " at worst" << std::endl;
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned depth = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20;
+	const unsigned num_threads = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+	const unsigned repetitions = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 5;
+	const unsigned long num_tasks = (2ul << depth) - 1;
+	std::cout << "Threads: " << num_threads << ", tasks per repetition: " << num_tasks << "\n";
+
+	Thread_pool pool(num_threads);
+	double best = 0;
+	double total = 0;
+	unsigned long total_allocations = 0;
+	for (unsigned i = 0; i < repetitions; ++i)
+	{
+		std::atomic<unsigned long> counter(0);
+		const auto allocations_start = heap_allocations();
+		auto start = std::chrono::steady_clock::now();
+		pool.submit([&pool, &counter, depth]() { spawn(pool, counter, depth); });
+		while (counter.load(std::memory_order_acquire) != num_tasks)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		total_allocations += heap_allocations() - allocations_start;
+		const double throughput = num_tasks / duration.count();
+		best = std::max(best, throughput);
+		total += throughput;
+	}
+	std::cout << "Average tasks per second: " << total / std::max(1u, repetitions) << "\n";
+	std::cout << "Best tasks per second: " << best << "\n";
+	std::cout << "Heap allocations per task: "
+			<< static_cast<double>(total_allocations) / (num_tasks * std::max(1u, repetitions)) << std::endl;
+	print_report(std::cout, pool.stats());
+
+	measure_idle();
+	measure_wake_up(pool, 20);
+}
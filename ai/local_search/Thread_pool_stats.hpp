@@ -0,0 +1,107 @@
+#ifndef AI_THREAD_POOL_STATS_HPP_
+#define AI_THREAD_POOL_STATS_HPP_
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+/**
+ * @brief Snapshot of the activity of a Thread_pool
+ */
+struct Thread_pool_stats
+{
+	struct Worker
+	{
+		std::uint64_t tasks() const noexcept { return local_tasks + pool_tasks + stolen_tasks; }
+
+		// Tasks taken from the worker's own queue
+		std::uint64_t local_tasks = 0;
+		// Tasks taken from the queue of the tasks submitted from outside the pool
+		std::uint64_t pool_tasks = 0;
+		// Tasks stolen from other workers
+		std::uint64_t stolen_tasks = 0;
+		// Rounds over the queues of all the other workers without finding a task
+		std::uint64_t failed_steals = 0;
+		std::uint64_t parks = 0;
+		std::chrono::nanoseconds idle_time{0};
+		// Largest number of tasks waiting in the worker's queue
+		std::uint64_t max_queue_depth = 0;
+	};
+
+	std::vector<Worker> workers;
+	// Tasks run by threads outside the pool, e.g. while waiting for a task group
+	std::uint64_t external_tasks = 0;
+	// Time since the creation of the pool
+	std::chrono::nanoseconds elapsed{0};
+};
+
+/**
+ * @brief Activity between two snapshots of the same pool, the queue depths are the ones of lhs
+ */
+inline Thread_pool_stats operator-(const Thread_pool_stats& lhs, const Thread_pool_stats& rhs)
+{
+	Thread_pool_stats result = lhs;
+	for (std::size_t i = 0; i < std::min(result.workers.size(), rhs.workers.size()); ++i)
+	{
+		auto& worker = result.workers[i];
+		const auto& earlier = rhs.workers[i];
+		worker.local_tasks -= earlier.local_tasks;
+		worker.pool_tasks -= earlier.pool_tasks;
+		worker.stolen_tasks -= earlier.stolen_tasks;
+		worker.failed_steals -= earlier.failed_steals;
+		worker.parks -= earlier.parks;
+		worker.idle_time -= earlier.idle_time;
+	}
+	result.external_tasks -= rhs.external_tasks;
+	result.elapsed -= rhs.elapsed;
+	return result;
+}
+
+/**
+ * @brief Prints a table of the worker counters and a summary of the load balance
+ */
+inline void print_report(std::ostream& os, const Thread_pool_stats& stats)
+{
+	auto percent = [](double part, double total) { return total > 0 ? 100 * part / total : 0.0; };
+	const double elapsed = std::max<double>(1, stats.elapsed.count());
+	std::uint64_t total_tasks = 0;
+	std::uint64_t max_tasks = 0;
+	std::uint64_t stolen_tasks = 0;
+	double idle_time = 0;
+
+	const auto flags = os.flags();
+	const auto precision = os.precision();
+	os << std::fixed << std::setprecision(1);
+	os << std::setw(6) << "worker" << std::setw(12) << "tasks" << std::setw(12) << "local" << std::setw(10) << "pool"
+			<< std::setw(10) << "stolen" << std::setw(14) << "failed steals" << std::setw(9) << "parks"
+			<< std::setw(8) << "idle%" << std::setw(11) << "max depth" << "\n";
+	for (std::size_t i = 0; i < stats.workers.size(); ++i)
+	{
+		const auto& worker = stats.workers[i];
+		os << std::setw(6) << i << std::setw(12) << worker.tasks()
+				<< std::setw(12) << worker.local_tasks
+				<< std::setw(10) << worker.pool_tasks
+				<< std::setw(10) << worker.stolen_tasks
+				<< std::setw(14) << worker.failed_steals
+				<< std::setw(9) << worker.parks
+				<< std::setw(8) << percent(worker.idle_time.count(), elapsed)
+				<< std::setw(11) << worker.max_queue_depth << "\n";
+		total_tasks += worker.tasks();
+		max_tasks = std::max(max_tasks, worker.tasks());
+		stolen_tasks += worker.stolen_tasks;
+		idle_time += worker.idle_time.count();
+	}
+	const double num_workers = std::max<std::size_t>(1, stats.workers.size());
+	os << "Tasks run by workers: " << total_tasks << ", by other threads: " << stats.external_tasks << "\n";
+	os << "Imbalance (busiest worker / average): " << std::setprecision(2)
+			<< (total_tasks != 0 ? max_tasks * num_workers / total_tasks : 0.0) << "\n";
+	os << std::setprecision(1) << "Stolen tasks: " << stolen_tasks << " (" << percent(stolen_tasks, total_tasks) << "%)\n";
+	os << "Average idle time: " << percent(idle_time / num_workers, elapsed) << "%\n";
+	os.flags(flags);
+	os.precision(precision);
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef AI_SEARCHING_TIME_TO_TARGET_HPP_
+#define AI_SEARCHING_TIME_TO_TARGET_HPP_
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cstdint>
+
+/**
+ * @brief One run of a time-to-target measurement
+ */
+struct Ttt_sample
+{
+	std::uint64_t seed;
+	bool reached;
+	double seconds;
+	unsigned long long iterations;
+	// Fitness or energy of the result
+	float value;
+};
+
+/**
+ * @brief Time-to-target harness: runs a stochastic algorithm many times with different seeds and records the time
+ * and the iterations it takes to reach a target fitness or energy
+ *
+ * The algorithm is any type with the interface of GA, PGA, Simulated_annealing or Parallel_tempering:
+ * seed(std::uint64_t), target(float) and iterations(). Runs which don't reach the target count as infinitely long,
+ * so the percentiles of the summary are those of the empirical run-time distribution, censored runs included.
+ */
+class Time_to_target
+{
+public:
+	/**
+	 * @param target fitness or energy at which a run is successful (the lower the better)
+	 */
+	explicit Time_to_target(float target = 0)
+	: target_(target)
+	{}
+	/**
+	 * @brief Runs an algorithm runs times, seeded with first_seed, first_seed + 1 and so on
+	 * @param name name of the algorithm in the CSV output
+	 * @param run callable taking the algorithm and the seed of the run and returning the result of a run
+	 * @param evaluate callable returning the fitness or the energy of a result
+	 */
+	template <typename Algorithm, typename Run, typename Evaluate>
+	void measure(const std::string& name,
+			Algorithm& algorithm,
+			Run run,
+			Evaluate evaluate,
+			unsigned runs,
+			std::uint64_t first_seed = 0);
+	/**
+	 * @brief Writes a CSV line per run: algorithm, seed, reached, seconds, iterations, value
+	 */
+	void write_runs(std::ostream& os) const;
+	/**
+	 * @brief Writes the empirical run-time distributions as CSV: for every successful run, in order of time,
+	 * the probability of reaching the target within its time and iterations
+	 */
+	void write_distributions(std::ostream& os) const;
+	/**
+	 * @brief Writes a CSV line per algorithm with the number of successful runs and the 50th, 90th and 99th
+	 * percentiles of the time and of the iterations
+	 */
+	void write_summary(std::ostream& os) const;
+	float target() const noexcept { return target_; }
+private:
+	struct Series
+	{
+		std::string name;
+		std::vector<Ttt_sample> samples;
+	};
+	/**
+	 * @return The nearest-rank percentile of sorted values, inf if it falls on a run which didn't reach the target
+	 */
+	static double percentile(const std::vector<double>& sorted, double p);
+
+	float target_;
+	std::vector<Series> series_;
+};
+
+template <typename Algorithm, typename Run, typename Evaluate>
+void Time_to_target::measure(const std::string& name,
+		Algorithm& algorithm,
+		Run run,
+		Evaluate evaluate,
+		unsigned runs,
+		std::uint64_t first_seed)
+{
+	typedef std::chrono::steady_clock Clock;
+	series_.push_back(Series{name, {}});
+	std::vector<Ttt_sample>& samples = series_.back().samples;
+	samples.reserve(runs);
+	algorithm.target(target_);
+	for (unsigned i = 0; i < runs; ++i)
+	{
+		const std::uint64_t seed = first_seed + i;
+		algorithm.seed(seed);
+		const auto start = Clock::now();
+		const auto result = run(algorithm, seed);
+		const std::chrono::duration<double> duration = Clock::now() - start;
+		const float value = static_cast<float>(evaluate(result));
+		samples.push_back(Ttt_sample{seed, value <= target_, duration.count(),
+				static_cast<unsigned long long>(algorithm.iterations()), value});
+	}
+}
+
+inline void Time_to_target::write_runs(std::ostream& os) const
+{
+	os << "algorithm,seed,reached,seconds,iterations,value\n";
+	for (const auto& series : series_)
+	{
+		for (const auto& sample : series.samples)
+		{
+			os << series.name << ',' << sample.seed << ',' << sample.reached << ',' << sample.seconds << ','
+					<< sample.iterations << ',' << sample.value << '\n';
+		}
+	}
+}
+
+inline void Time_to_target::write_distributions(std::ostream& os) const
+{
+	os << "algorithm,seconds,iterations,probability\n";
+	for (const auto& series : series_)
+	{
+		std::vector<Ttt_sample> reached;
+		std::copy_if(series.samples.begin(), series.samples.end(), std::back_inserter(reached),
+				[](const Ttt_sample& sample) { return sample.reached; });
+		std::sort(reached.begin(), reached.end(), [](const Ttt_sample& lhs, const Ttt_sample& rhs)
+				{
+					return lhs.seconds < rhs.seconds;
+				});
+		for (std::size_t i = 0; i < reached.size(); ++i)
+		{
+			os << series.name << ',' << reached[i].seconds << ',' << reached[i].iterations << ','
+					<< static_cast<double>(i + 1) / series.samples.size() << '\n';
+		}
+	}
+}
+
+inline void Time_to_target::write_summary(std::ostream& os) const
+{
+	static constexpr double percentiles[] = {0.5, 0.9, 0.99};
+	os << "algorithm,runs,reached,seconds_p50,seconds_p90,seconds_p99,iterations_p50,iterations_p90,iterations_p99\n";
+	for (const auto& series : series_)
+	{
+		const double inf = std::numeric_limits<double>::infinity();
+		std::vector<double> seconds;
+		std::vector<double> iterations;
+		for (const auto& sample : series.samples)
+		{
+			seconds.push_back(sample.reached ? sample.seconds : inf);
+			iterations.push_back(sample.reached ? static_cast<double>(sample.iterations) : inf);
+		}
+		std::sort(seconds.begin(), seconds.end());
+		std::sort(iterations.begin(), iterations.end());
+		os << series.name << ',' << series.samples.size() << ','
+				<< std::count_if(series.samples.begin(), series.samples.end(),
+						[](const Ttt_sample& sample) { return sample.reached; });
+		for (double p : percentiles)
+		{
+			os << ',' << percentile(seconds, p);
+		}
+		for (double p : percentiles)
+		{
+			os << ',' << percentile(iterations, p);
+		}
+		os << '\n';
+	}
+}
+
+inline double Time_to_target::percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+	{
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	const std::size_t rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+	return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+#endif
@@ -0,0 +1,90 @@
+/**
+	Time-to-target comparison of GA, PGA, simulated annealing and parallel tempering on the 12-queens puzzle:
+	every algorithm runs with seeds 0, 1, 2... until it finds a solution or runs out of iterations.
+	The summary (percentiles of time and iterations) goes to standard output, or to a file along with the
+	runs and the empirical run-time distributions.
+	Usage: Ttt_benchmark [runs] [summary csv] [runs csv] [distributions csv]
+ */
+
+#include "N_queens.hpp"
+#include "GA.hpp"
+#include "Simulated_annealing.hpp"
+#include "Parallel_tempering.hpp"
+#include "Time_to_target.hpp"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+
+	constexpr unsigned size = 12;
+	constexpr unsigned generations = 1000;
+	constexpr unsigned population = 500;
+	constexpr unsigned long long max_iterations = 2000000;
+
+	typedef N_queens<size> State;
+
+	/**
+	 * Constant temperature, until the maximum number of iterations
+	 */
+	struct Constant_schedule
+	{
+		float operator()(unsigned long long t) const
+		{
+			return t < max_iterations ? 0.2f : 0.0f;
+		}
+	};
+
+	/**
+	 * The annealing algorithms start from a configuration depending only on the seed
+	 */
+	State start_state(std::uint64_t seed)
+	{
+		std::mt19937 re(static_cast<std::uint32_t>(seed));
+		return random_queens_configuration<size>(re);
+	}
+
+	bool write(const char* path, const Time_to_target& ttt, void (Time_to_target::*output)(std::ostream&) const)
+	{
+		std::ofstream file(path);
+		(ttt.*output)(file);
+		if (!file)
+		{
+			std::cerr << "Can't write " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned runs = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20;
+	Time_to_target ttt(0);
+	const Energy_evaluation<size> energy;
+	GA<State, Pop_generator<size>, Energy_evaluation<size>, Mutagen<size>> ga;
+	ttt.measure("GA", ga, [](auto& algorithm, std::uint64_t) { return algorithm(generations, population); },
+			energy, runs);
+	PGA<State, Pop_generator<size>, Energy_evaluation<size>, Mutagen<size>> pga;
+	ttt.measure("PGA", pga, [](auto& algorithm, std::uint64_t) { return algorithm(generations, population); },
+			energy, runs);
+	Simulated_annealing<State, Move_piece_generator<size>, Energy_evaluation<size>, Constant_schedule> sa;
+	ttt.measure("SA", sa, [](auto& algorithm, std::uint64_t seed) { return algorithm(start_state(seed)); },
+			energy, runs);
+	Parallel_tempering<State, Move_piece_generator<size>, Energy_evaluation<size>, Constant_schedule> pt(
+			Move_piece_generator<size>(), Energy_evaluation<size>(), Constant_schedule(), 4);
+	ttt.measure("PT", pt, [](auto& algorithm, std::uint64_t seed) { return algorithm(start_state(seed)); },
+			energy, runs);
+	if (argc > 2)
+	{
+		const bool written = write(argv[2], ttt, &Time_to_target::write_summary) &&
+				(argc <= 3 || write(argv[3], ttt, &Time_to_target::write_runs)) &&
+				(argc <= 4 || write(argv[4], ttt, &Time_to_target::write_distributions));
+		return written ? 0 : 1;
+	}
+	ttt.write_summary(std::cout);
+}
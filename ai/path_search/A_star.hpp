@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <memory>
 #include <utility>
 #include <algorithm>
@@ -12,6 +13,10 @@
 #include <set>
 #include <limits>
 #include <tuple>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include "Search_checkpoint.hpp"
 
 template <typename State, typename Action> class A_star_node;
 template <typename State, typename Action> using A_star_node_ptr = std::unique_ptr<A_star_node<State, Action>>;
@@ -204,6 +209,30 @@ namespace detail
 	    }
 	};
 
+	/**
+	 * Generators may also accept the action that led to the state and the goal of the search,
+	 * which is what direction-pruning schemes such as jump point search need
+	 */
+	template <typename Generator, typename State, typename Action>
+	inline auto generate_successors(const Generator& generator,
+			const State& state,
+			const Action& action,
+			const State& goal,
+			int) -> decltype(generator(state, action, goal))
+	{
+		return generator(state, action, goal);
+	}
+
+	template <typename Generator, typename State, typename Action>
+	inline auto generate_successors(const Generator& generator,
+			const State& state,
+			const Action&,
+			const State&,
+			long) -> decltype(generator(state))
+	{
+		return generator(state);
+	}
+
 	template <typename Node, typename Frontier, typename Frontier_set>
 	inline void a_star_add_frontier(Node&& node, Frontier& frontier, Frontier_set& frontier_set)
 	{
@@ -305,11 +334,12 @@ std::vector<A_star_node_ptr<State, Action>> A_star_node<State, Action>::successo
 		const State& goal) const
 {
 	std::vector<A_star_node_ptr<State, Action>> children;
-	for (auto& successor : generator(this->state))
+	for (auto& successor : detail::generate_successors(generator, this->state, this->action, goal, 0))
 	{
-		auto f_cost = this->g_cost + heuristic(std::get<0>(successor), goal);
+		auto g_cost = this->g_cost + std::get<2>(successor);
+		auto f_cost = g_cost + heuristic(std::get<0>(successor), goal);
 		children.push_back(std::make_unique<A_star_node<State, Action>>(f_cost,
-				this->g_cost + std::get<2>(successor),
+				g_cost,
 				std::move(std::get<0>(successor)),
 				std::move(std::get<1>(successor)),
 				this));
@@ -321,7 +351,6 @@ std::vector<A_star_node_ptr<State, Action>> A_star_node<State, Action>::successo
 namespace std
 {
 
-	template <>
 	template <typename State, typename Action>
 	struct hash<A_star_node<State, Action>*>
 	{
@@ -331,6 +360,24 @@ namespace std
 		}
 	};
 
+	template <typename State, typename Action>
+	struct hash<A_star_node_ptr<State, Action>>
+	{
+		inline std::size_t operator()(const A_star_node_ptr<State, Action>& x) const
+		{
+			return std::hash<State>()(x->state);
+		}
+	};
+
+	template <typename State, typename Action>
+	struct hash<IEA_star_node_ptr<State, Action>>
+	{
+		inline std::size_t operator()(const IEA_star_node_ptr<State, Action>& x) const
+		{
+			return std::hash<State>()(x->state);
+		}
+	};
+
 }
 
 
@@ -373,6 +420,11 @@ A_star_search<State, Action, Generator, Heuristic, Result_policy>::operator()(St
 		}
 
 		auto insert_pair = explored.insert(std::move(node_ptr));
+		if (!insert_pair.second)
+		{
+			// Stale entry left behind by a cheaper path to the same state
+			continue;
+		}
 		if ((*insert_pair.first)->g_cost > max_cost)
 		{
 			cutoff_occurred = true;
@@ -390,7 +442,9 @@ A_star_search<State, Action, Generator, Heuristic, Result_policy>::operator()(St
 			}
 			else if ((*frontier_successor_it)->f_cost > successor_ptr->f_cost)
 			{
-				*(*frontier_successor_it) = *successor_ptr.get();
+				// Nodes can't be modified while in the heap: push the cheaper one and let the old one go stale
+				frontier_set.erase(frontier_successor_it);
+				detail::a_star_add_frontier(std::move(successor_ptr), frontier, frontier_set);
 			}
 		}
 	}
@@ -414,6 +468,25 @@ public:
 	using typename Base::Result;
 	using Base::Base;
 	Result_type operator()(State start, State goal, float max_cost = std::numeric_limits<float>::max()) const;
+	/**
+	 * @brief Runs the search periodically saving its progress
+	 *
+	 * Checkpoints store the current f-limit and the position reached by the depth-first visit,
+	 * thus the generator must return successors always in the same order.
+	 */
+	Result_type operator()(State start,
+			State goal,
+			Checkpoint_writer& checkpoint,
+			float max_cost = std::numeric_limits<float>::max()) const;
+	/**
+	 * @brief Continues a search from a checkpoint file
+	 *
+	 * @param checkpoint optional writer used to keep saving the progress
+	 * @throw std::runtime_error if the checkpoint can't be read
+	 */
+	Result_type resume(const std::string& path,
+			Checkpoint_writer* checkpoint = nullptr,
+			float max_cost = std::numeric_limits<float>::max()) const;
 protected:
 	Result_type iteration_cutoff() const
 	{
@@ -422,10 +495,74 @@ protected:
 private:
 	typedef A_star_node<State, Action> Node;
 	typedef A_star_node_ptr<State, Action> Node_ptr;
+	struct Progress;
+	struct Snapshot;
+	/**
+	 * Position of the depth-first visit at a depth. Frames live on the stack of the recursion, linked to the
+	 * frame of the parent, and are walked only to take a checkpoint
+	 */
+	struct Frame
+	{
+		const Frame* parent;
+		// Successor being visited
+		std::uint32_t index;
+		// Lowest f_cost over the limit found so far below this depth
+		float min;
+	};
+	Result_type run(Progress& progress, float max_cost) const;
 	std::pair<Result_type, float> search(const Node_ptr& node_ptr,
 			const State& goal,
 			const float& f_limit,
-			const float& max_cost) const;
+			const float& max_cost,
+			Progress* progress = nullptr,
+			const Frame* parent = nullptr,
+			std::size_t depth = 0) const;
+	void save_checkpoint(const Progress& progress, const Frame* frame, std::size_t depth) const;
+	static constexpr std::uint32_t checkpoint_ticks = 1024;
+};
+
+namespace detail
+{
+
+	constexpr char ida_star_checkpoint_magic[] = "IDA*CKP1";
+	constexpr char iea_star_checkpoint_magic[] = "IEA*CKP1";
+
+}
+
+/**
+ * State of an IDA* search, as much as it's needed to resume it
+ */
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+struct IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::Progress
+{
+	State start;
+	State goal;
+	float f_limit;
+	// Lowest f_cost over the limit found in this iteration before a resume
+	float next_f_limit;
+	// Position to reach again after a resume
+	std::vector<std::uint32_t> resume_trail;
+	bool resuming;
+	Checkpoint_writer* checkpoint;
+	std::uint32_t ticks;
+};
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+struct IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::Snapshot
+{
+	State start;
+	State goal;
+	float f_limit;
+	float next_f_limit;
+	std::vector<std::uint32_t> trail;
 };
 
 template <typename State,
@@ -463,7 +600,10 @@ std::pair<typename IDA_star_search<State, Action, Generator, Heuristic, Result_p
 IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::search(const Node_ptr& node_ptr,
 		const State& goal,
 		const float& f_limit,
-		const float& max_cost) const
+		const float& max_cost,
+		Progress* progress,
+		const Frame* parent,
+		std::size_t depth) const
 {
 	bool cutoff_occurred = false;
 	if (node_ptr->f_cost > f_limit)
@@ -480,13 +620,39 @@ IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::search(cons
 			f_limit};
 	}
 
-	float min = std::numeric_limits<float>::max();
-	for (const auto& successor_ptr : node_ptr->successors(this->generator_, this->heuristic_, goal))
+	if (progress != nullptr && progress->checkpoint != nullptr &&
+			++progress->ticks % checkpoint_ticks == 0 && progress->checkpoint->due())
 	{
-		auto result = search(successor_ptr, goal, f_limit, max_cost);
-		if (result.second < min)
+		save_checkpoint(*progress, parent, depth);
+	}
+
+	Frame frame{parent, 0, std::numeric_limits<float>::max()};
+	const auto successors = node_ptr->successors(this->generator_, this->heuristic_, goal);
+	std::size_t first = 0;
+	// Only the nodes on the path to the position of a resume skip successors
+	const bool resumed = progress != nullptr && progress->resuming;
+	if (resumed)
+	{
+		if (depth < progress->resume_trail.size())
 		{
-			min = result.second;
+			first = progress->resume_trail[depth];
+		}
+		else
+		{
+			progress->resuming = false;
+		}
+	}
+	for (std::size_t i = first; i < successors.size(); ++i)
+	{
+		frame.index = static_cast<std::uint32_t>(i);
+		auto result = search(successors[i], goal, f_limit, max_cost, progress, &frame, depth + 1);
+		if (resumed)
+		{
+			progress->resuming = false;
+		}
+		if (result.second < frame.min)
+		{
+			frame.min = result.second;
 		}
 		if (result.first.second == Result::iteration_cutoff)
 		{
@@ -499,9 +665,129 @@ IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::search(cons
 	}
 	if (cutoff_occurred)
 	{
-		return {this->iteration_cutoff(), min};
+		return {this->iteration_cutoff(), frame.min};
 	}
-	return {this->failure(), min};
+	return {this->failure(), frame.min};
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::operator()(State start,
+		State goal,
+		Checkpoint_writer& checkpoint,
+		float max_cost) const
+{
+	const float f_limit = this->heuristic_(start, goal);
+	Progress progress{std::move(start),
+			std::move(goal),
+			f_limit,
+			std::numeric_limits<float>::max(),
+			{},
+			false,
+			&checkpoint,
+			0};
+	return run(progress, max_cost);
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::resume(const std::string& path,
+		Checkpoint_writer* checkpoint,
+		float max_cost) const
+{
+	std::ifstream is(path, std::ios::binary);
+	if (!is)
+	{
+		throw std::runtime_error("can't open checkpoint " + path);
+	}
+	detail::checkpoint_check_header(is, detail::ida_star_checkpoint_magic);
+	auto start = detail::checkpoint_read<State>(is);
+	auto goal = detail::checkpoint_read<State>(is);
+	const auto f_limit = detail::checkpoint_read<float>(is);
+	const auto next_f_limit = detail::checkpoint_read<float>(is);
+	std::vector<std::uint32_t> trail(detail::checkpoint_read<std::uint64_t>(is));
+	for (auto& index : trail)
+	{
+		index = detail::checkpoint_read<std::uint32_t>(is);
+	}
+	const bool resuming = !trail.empty();
+	Progress progress{std::move(start),
+			std::move(goal),
+			f_limit,
+			next_f_limit,
+			std::move(trail),
+			resuming,
+			checkpoint,
+			0};
+	return run(progress, max_cost);
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::run(Progress& progress, float max_cost) const
+{
+	auto root_ptr = std::make_unique<Node>(this->heuristic_(progress.start, progress.goal),
+			0,
+			progress.start,
+			Action(),
+			nullptr);
+	while (true)
+	{
+		auto src_result = search(root_ptr, progress.goal, progress.f_limit, max_cost, &progress);
+		if (src_result.first.second != Result::iteration_cutoff)
+		{
+			return std::move(src_result.first);
+		}
+		// Cutoffs found before a resume are remembered only by next_f_limit
+		progress.f_limit = std::min(src_result.second, progress.next_f_limit);
+		progress.next_f_limit = std::numeric_limits<float>::max();
+		progress.resume_trail.clear();
+		progress.resuming = false;
+	}
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void IDA_star_search<State, Action, Generator, Heuristic, Result_policy>::save_checkpoint(const Progress& progress,
+		const Frame* frame,
+		std::size_t depth) const
+{
+	// The cutoffs found so far in this iteration are the ones of the subtrees already visited
+	Snapshot snapshot{progress.start, progress.goal, progress.f_limit, progress.next_f_limit,
+			std::vector<std::uint32_t>(depth)};
+	for (; frame != nullptr; frame = frame->parent)
+	{
+		snapshot.trail[--depth] = frame->index;
+		snapshot.next_f_limit = std::min(snapshot.next_f_limit, frame->min);
+	}
+	progress.checkpoint->save(std::move(snapshot), [](std::ostream& os, const Snapshot& snapshot)
+			{
+				detail::checkpoint_write_header(os, detail::ida_star_checkpoint_magic);
+				detail::checkpoint_write(os, snapshot.start);
+				detail::checkpoint_write(os, snapshot.goal);
+				detail::checkpoint_write(os, snapshot.f_limit);
+				detail::checkpoint_write(os, snapshot.next_f_limit);
+				detail::checkpoint_write(os, static_cast<std::uint64_t>(snapshot.trail.size()));
+				for (auto index : snapshot.trail)
+				{
+					detail::checkpoint_write(os, index);
+				}
+			});
 }
 
 
@@ -522,10 +808,59 @@ public:
 	using typename Base::Result;
 	using Base::Base;
 	Result_type operator()(State start, State goal, float max_cost = std::numeric_limits<float>::max()) const;
+	/**
+	 * @brief Runs the search periodically saving frontier, explored set and f-limit
+	 */
+	Result_type operator()(State start,
+			State goal,
+			Checkpoint_writer& checkpoint,
+			float max_cost = std::numeric_limits<float>::max()) const;
+	/**
+	 * @brief Continues a search from a checkpoint file
+	 *
+	 * @param checkpoint optional writer used to keep saving the progress
+	 * @throw std::runtime_error if the checkpoint can't be read
+	 */
+	Result_type resume(const std::string& path,
+			Checkpoint_writer* checkpoint = nullptr,
+			float max_cost = std::numeric_limits<float>::max()) const;
 private:
 	typedef A_star_node<State, Action> Node;
 	typedef IEA_star_node_ptr<State, Action> Node_ptr;
 	using Node_set = std::unordered_set<Node_ptr>;
+	using Frontier = std::priority_queue<Node_ptr,
+			std::vector<Node_ptr>,
+			std::greater<Node_ptr>>;
+	struct Progress
+	{
+		State goal;
+		Frontier frontier;
+		Frontier new_frontier;
+		Node_set explored;
+		float f_limit;
+		float new_f_limit;
+		// Owns the nodes loaded from a checkpoint
+		std::vector<Node_ptr> nodes;
+		// The explored set in order of insertion, kept only while checkpointing: chunks never change once
+		// a snapshot shares them, so a snapshot copies only the nodes explored since the previous one
+		std::vector<std::shared_ptr<const std::vector<Node_ptr>>> explored_chunks;
+		std::vector<Node_ptr> new_explored;
+		std::uint32_t ticks = 0;
+	};
+	struct Snapshot
+	{
+		State goal;
+		float f_limit;
+		float new_f_limit;
+		std::vector<std::shared_ptr<const std::vector<Node_ptr>>> explored;
+		std::vector<Node_ptr> frontier;
+		std::vector<Node_ptr> new_frontier;
+	};
+	Result_type run(Progress& progress, float max_cost, Checkpoint_writer* checkpoint) const;
+	void save_checkpoint(Progress& progress, Checkpoint_writer& checkpoint) const;
+	static void write_snapshot(std::ostream& os, const Snapshot& snapshot);
+	// Frontier expansions between two checks of the checkpoint clock, an expansion runs a whole f-limited search
+	static constexpr std::uint32_t checkpoint_ticks = 16;
 	std::pair<Result_type, float> f_limited_search(const Node_ptr& node_ptr,
 			std::vector<Node_ptr>& successors,
 			const Node_set& explored,
@@ -569,50 +904,267 @@ IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::operator()(
 		State goal,
 		float max_cost) const
 {
-	using Frontier = std::priority_queue<Node_ptr,
-			std::vector<Node_ptr>,
-			std::greater<Node_ptr>>;
+	Progress progress{std::move(goal), {}, {}, {}, 0, 0, {}, {}, {}, 0};
+	auto root_ptr = std::make_shared<Node>(this->heuristic_(start, progress.goal), 0, start, Action(), nullptr);
+	progress.f_limit = root_ptr->f_cost;
+	progress.explored.insert(root_ptr);
+	progress.frontier.push(std::move(root_ptr));
+	return run(progress, max_cost, nullptr);
+}
 
-	Frontier frontier;
-	Node_set explored;
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::operator()(State start,
+		State goal,
+		Checkpoint_writer& checkpoint,
+		float max_cost) const
+{
+	Progress progress{std::move(goal), {}, {}, {}, 0, 0, {}, {}, {}, 0};
+	auto root_ptr = std::make_shared<Node>(this->heuristic_(start, progress.goal), 0, start, Action(), nullptr);
+	progress.f_limit = root_ptr->f_cost;
+	progress.explored.insert(root_ptr);
+	progress.frontier.push(std::move(root_ptr));
+	return run(progress, max_cost, &checkpoint);
+}
 
-	auto root_ptr = std::make_shared<Node>(this->heuristic_(start, goal), 0, start, Action(), nullptr);
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::run(Progress& progress,
+		float max_cost,
+		Checkpoint_writer* checkpoint) const
+{
+	if (checkpoint != nullptr && progress.explored_chunks.empty())
+	{
+		progress.new_explored.assign(progress.explored.cbegin(), progress.explored.cend());
+	}
 	Result_type result = this->iteration_cutoff();
-	float f_limit = root_ptr->f_cost;
-	explored.insert(root_ptr);
-	frontier.push(std::move(root_ptr));
 	while (result.second == Result::iteration_cutoff)
 	{
-		Frontier new_frontier;
-		float new_f_limit = f_limit;
-		while (!frontier.empty())
+		progress.new_f_limit = progress.f_limit;
+		while (!progress.frontier.empty())
 		{
-			const auto best = std::move(const_cast<typename Frontier::value_type&>(frontier.top()));
-			frontier.pop();
+			const auto best = std::move(const_cast<typename Frontier::value_type&>(progress.frontier.top()));
+			progress.frontier.pop();
 			std::vector<Node_ptr> successors;
-			auto src_result = f_limited_search(best, successors, explored, goal, f_limit, new_f_limit, max_cost);
+			auto src_result = f_limited_search(best,
+					successors,
+					progress.explored,
+					progress.goal,
+					progress.f_limit,
+					progress.new_f_limit,
+					max_cost);
 			result = std::move(src_result.first);
 			if (result.second != Result::iteration_cutoff)
 			{
 				return result;
 			}
-			if ((src_result.second < new_f_limit || new_f_limit == f_limit) && src_result.second > f_limit)
+			if ((src_result.second < progress.new_f_limit || progress.new_f_limit == progress.f_limit) &&
+					src_result.second > progress.f_limit)
 			{
-				new_f_limit = src_result.second;
+				progress.new_f_limit = src_result.second;
 			}
-			const auto expansion = expand_frontier(std::move(best), successors, explored, f_limit);
+			const auto expansion = expand_frontier(std::move(best), successors, progress.explored, progress.f_limit);
 			for (const auto& node_ptr : expansion)
 			{
-				explored.insert(node_ptr);
-				new_frontier.push(std::move(node_ptr));
+				progress.explored.insert(node_ptr);
+				progress.new_frontier.push(std::move(node_ptr));
+			}
+			if (checkpoint != nullptr)
+			{
+				progress.new_explored.insert(progress.new_explored.end(), expansion.cbegin(), expansion.cend());
+				if (++progress.ticks % checkpoint_ticks == 0 && checkpoint->due())
+				{
+					save_checkpoint(progress, *checkpoint);
+				}
 			}
 		}
-		frontier = std::move(new_frontier);
-		f_limit = new_f_limit;
+		progress.frontier = std::move(progress.new_frontier);
+		progress.new_frontier = Frontier();
+		progress.f_limit = progress.new_f_limit;
 	}
 	return result;
 }
 
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::resume(const std::string& path,
+		Checkpoint_writer* checkpoint,
+		float max_cost) const
+{
+	std::ifstream is(path, std::ios::binary);
+	if (!is)
+	{
+		throw std::runtime_error("can't open checkpoint " + path);
+	}
+	detail::checkpoint_check_header(is, detail::iea_star_checkpoint_magic);
+	Progress progress{detail::checkpoint_read<State>(is), {}, {}, {}, 0, 0, {}, {}, {}, 0};
+	progress.f_limit = detail::checkpoint_read<float>(is);
+	progress.new_f_limit = detail::checkpoint_read<float>(is);
+	// Nodes are stored with parents before children
+	progress.nodes.resize(detail::checkpoint_read<std::uint64_t>(is));
+	for (std::size_t i = 0; i < progress.nodes.size(); ++i)
+	{
+		const auto f_cost = detail::checkpoint_read<float>(is);
+		const auto g_cost = detail::checkpoint_read<float>(is);
+		auto state = detail::checkpoint_read<State>(is);
+		auto action = detail::checkpoint_read<Action>(is);
+		const auto parent = detail::checkpoint_read<std::uint64_t>(is);
+		if (parent != std::numeric_limits<std::uint64_t>::max() && parent >= i)
+		{
+			throw std::runtime_error("checkpoint is corrupted");
+		}
+		progress.nodes[i] = std::make_shared<Node>(f_cost,
+				g_cost,
+				std::move(state),
+				std::move(action),
+				parent == std::numeric_limits<std::uint64_t>::max() ? nullptr : progress.nodes[parent].get());
+	}
+	auto read_ids = [&is, &progress](auto insert)
+			{
+				const auto size = detail::checkpoint_read<std::uint64_t>(is);
+				for (std::uint64_t i = 0; i < size; ++i)
+				{
+					const auto id = detail::checkpoint_read<std::uint64_t>(is);
+					if (id >= progress.nodes.size())
+					{
+						throw std::runtime_error("checkpoint is corrupted");
+					}
+					insert(progress.nodes[id]);
+				}
+			};
+	read_ids([&progress](const Node_ptr& node_ptr) { progress.explored.insert(node_ptr); });
+	read_ids([&progress](const Node_ptr& node_ptr) { progress.frontier.push(node_ptr); });
+	read_ids([&progress](const Node_ptr& node_ptr) { progress.new_frontier.push(node_ptr); });
+	return run(progress, max_cost, checkpoint);
+}
+
+namespace detail
+{
+
+	/**
+	 * Read access to the container of a priority queue
+	 */
+	template <typename Queue>
+	struct Priority_queue_access : Queue
+	{
+		static const typename Queue::container_type& container(const Queue& queue)
+		{
+			return queue.*(&Priority_queue_access::c);
+		}
+	};
+
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::save_checkpoint(Progress& progress,
+		Checkpoint_writer& checkpoint) const
+{
+	// Nodes never change after their creation, so copying the pointers is enough for a consistent snapshot
+	typedef detail::Priority_queue_access<Frontier> Access;
+	if (!progress.new_explored.empty())
+	{
+		progress.explored_chunks.push_back(std::make_shared<const std::vector<Node_ptr>>(
+				std::move(progress.new_explored)));
+		progress.new_explored.clear();
+	}
+	Snapshot snapshot{progress.goal,
+			progress.f_limit,
+			progress.new_f_limit,
+			progress.explored_chunks,
+			Access::container(progress.frontier),
+			Access::container(progress.new_frontier)};
+	checkpoint.save(std::move(snapshot), &IEA_star_search::write_snapshot);
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void IEA_star_search<State, Action, Generator, Heuristic, Result_policy>::write_snapshot(std::ostream& os,
+		const Snapshot& snapshot)
+{
+	std::unordered_map<const Node*, std::uint64_t> ids;
+	std::vector<const Node*> nodes;
+	auto add = [&ids, &nodes](const Node* node)
+			{
+				std::vector<const Node*> chain;
+				while (node != nullptr && ids.find(node) == ids.cend())
+				{
+					chain.push_back(node);
+					node = node->parent;
+				}
+				for (auto it = chain.crbegin(); it != chain.crend(); ++it)
+				{
+					ids.emplace(*it, nodes.size());
+					nodes.push_back(*it);
+				}
+			};
+	std::uint64_t num_explored = 0;
+	for (const auto& chunk : snapshot.explored)
+	{
+		num_explored += chunk->size();
+		for (const auto& node_ptr : *chunk)
+		{
+			add(node_ptr.get());
+		}
+	}
+	for (const auto* list : {&snapshot.frontier, &snapshot.new_frontier})
+	{
+		for (const auto& node_ptr : *list)
+		{
+			add(node_ptr.get());
+		}
+	}
+
+	detail::checkpoint_write_header(os, detail::iea_star_checkpoint_magic);
+	detail::checkpoint_write(os, snapshot.goal);
+	detail::checkpoint_write(os, snapshot.f_limit);
+	detail::checkpoint_write(os, snapshot.new_f_limit);
+	detail::checkpoint_write(os, static_cast<std::uint64_t>(nodes.size()));
+	for (const auto* node : nodes)
+	{
+		detail::checkpoint_write(os, node->f_cost);
+		detail::checkpoint_write(os, node->g_cost);
+		detail::checkpoint_write(os, node->state);
+		detail::checkpoint_write(os, node->action);
+		detail::checkpoint_write(os, node->parent == nullptr ?
+				std::numeric_limits<std::uint64_t>::max() : ids.at(node->parent));
+	}
+	detail::checkpoint_write(os, num_explored);
+	for (const auto& chunk : snapshot.explored)
+	{
+		for (const auto& node_ptr : *chunk)
+		{
+			detail::checkpoint_write(os, ids.at(node_ptr.get()));
+		}
+	}
+	for (const auto* list : {&snapshot.frontier, &snapshot.new_frontier})
+	{
+		detail::checkpoint_write(os, static_cast<std::uint64_t>(list->size()));
+		for (const auto& node_ptr : *list)
+		{
+			detail::checkpoint_write(os, ids.at(node_ptr.get()));
+		}
+	}
+}
+
 template <typename State,
 		typename Action,
 		typename Generator,
@@ -0,0 +1,84 @@
+/**
+	Saves the progress of IDA* and IEA* searches to a checkpoint file and resumes them from it.
+	Each search is run three times: without checkpoints, with periodic checkpoints and finally resumed
+	from the last checkpoint written, as if the previous run had been interrupted.
+	Usage: Checkpoint_example [checkpoint interval in milliseconds] [checkpoint file]
+ */
+
+#include "A_star.hpp"
+#include "Search_checkpoint.hpp"
+#include "puzzle_board.hpp"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+
+typedef Puzzle_board<3> Puzzle_8;
+typedef Puzzle_successors_gen<Puzzle_8::size> Gen;
+typedef Puzzle_heuristic_manhattan<Puzzle_8::size> Heuristic;
+typedef IDA_star_search<Puzzle_8, Puzzle_action, Gen, Heuristic, Full_result> IDA_star;
+typedef IEA_star_search<Puzzle_8, Puzzle_action, Gen, Heuristic, Full_result> IEA_star;
+
+namespace
+{
+
+	const Puzzle_8 start({{{{8, 6, 7}}, {{2, 5, 4}}, {{3, 0, 1}}}});
+	const Puzzle_8 goal({{{{1, 2, 3}}, {{4, 5, 6}}, {{7, 8, 0}}}});
+
+	template <typename Function>
+	typename std::result_of<Function()>::type timed(const char* name, Function function)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		auto result = function();
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0);
+		std::cout << name << ": ";
+		if (result.second == decltype(result.second)::success)
+		{
+			std::cout << result.first->size() << " steps";
+		}
+		else
+		{
+			std::cout << "no solution";
+		}
+		std::cout << ", " << duration.count() << " microseconds" << std::endl;
+		return result;
+	}
+
+	template <typename Solver>
+	bool run(const char* name, const Solver& solver, std::chrono::milliseconds interval, const std::string& path)
+	{
+		std::cout << "--- " << name << "\n";
+		std::remove(path.c_str());
+		const auto plain = timed("Without checkpoints", [&]() { return solver(start, goal); });
+		unsigned written = 0;
+		const auto saved = timed("With checkpoints", [&]()
+				{
+					Checkpoint_writer checkpoint(path, interval);
+					auto result = solver(start, goal, checkpoint);
+					checkpoint.wait();
+					written = checkpoint.written();
+					return result;
+				});
+		std::cout << "Checkpoints written: " << written << std::endl;
+		if (written == 0)
+		{
+			std::cout << "The search ended before the first checkpoint, try a shorter interval" << std::endl;
+			return true;
+		}
+		const auto resumed = timed("Resumed from the last checkpoint", [&]() { return solver.resume(path); });
+		std::remove(path.c_str());
+		return plain.first->size() == saved.first->size() && plain.first->size() == resumed.first->size();
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const std::chrono::milliseconds interval((argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10);
+	const std::string path = (argc > 2) ? argv[2] : "search.ckp";
+	bool consistent = run("IDA*", IDA_star(Gen{}, Heuristic{goal}), interval, path);
+	consistent = run("IEA*", IEA_star(Gen{}, Heuristic{goal}), interval, path) && consistent;
+	std::cout << (consistent ? "All the runs found paths of the same length" : "Path lengths differ!") << std::endl;
+	return consistent ? EXIT_SUCCESS : EXIT_FAILURE;
+}
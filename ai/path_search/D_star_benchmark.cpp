@@ -0,0 +1,134 @@
+/**
+	Compares incremental replanning with D* Lite against running A* from scratch.
+	An agent walks along its path while random obstacles are toggled near the path ahead of it;
+	after every change both planners compute a new path from the agent's position.
+	Usage: D_star_benchmark [number of rounds] [map size]
+ */
+
+#include "A_star.hpp"
+#include "D_star_lite.hpp"
+#include "Grid_map.hpp"
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+typedef A_star_search<Grid_pos, Grid_action, Grid_successors_gen, Grid_heuristic_octile, Full_result> Grid_A_star;
+typedef D_star_lite_search<Grid_pos, Grid_action, Grid_successors_gen, Grid_heuristic_octile, Full_result> Grid_D_star;
+
+namespace
+{
+
+	constexpr unsigned steps_per_round = 4;
+	constexpr unsigned toggles_per_round = 8;
+	constexpr std::int32_t toggle_radius = 6;
+
+	float path_cost(const Grid_A_star::Result_type& result)
+	{
+		if (result.second != Grid_A_star::Result::success)
+		{
+			return -1;
+		}
+		return result.first->empty() ? 0.0f : result.first->back().g_cost;
+	}
+
+	template <typename Clock_duration>
+	long long micro(Clock_duration d)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+	}
+
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned rounds = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100;
+	const std::int32_t size = (argc > 2) ? std::strtol(argv[2], nullptr, 10) : 512;
+	std::mt19937 re(42);
+	std::bernoulli_distribution obstacle_dist(0.2);
+	Grid_map map(size, size);
+	for (std::int32_t y = 0; y < size; ++y)
+	{
+		for (std::int32_t x = 0; x < size; ++x)
+		{
+			if (obstacle_dist(re))
+			{
+				map.set_blocked(x, y);
+			}
+		}
+	}
+	Grid_pos start{0, 0};
+	const Grid_pos goal{size - 1, size - 1};
+	map.set_blocked(start, false);
+	map.set_blocked(goal, false);
+
+	Grid_A_star a_star{Grid_successors_gen(map)};
+	Grid_D_star d_star{Grid_successors_gen(map)};
+
+	auto t0 = std::chrono::steady_clock::now();
+	auto result = d_star(start, goal);
+	std::cout << "Map size: " << size << "x" << size << "\n";
+	std::cout << "Initial D* Lite plan: " << micro(std::chrono::steady_clock::now() - t0) << " microseconds, "
+			<< d_star.expansions() << " expansions\n";
+
+	long long d_star_time = 0;
+	long long a_star_time = 0;
+	std::size_t d_star_expansions = 0;
+	unsigned mismatches = 0;
+	unsigned completed = 0;
+	std::uniform_int_distribution<std::int32_t> offset_dist(-toggle_radius, toggle_radius);
+	for (unsigned round = 0; round < rounds && result.second == Grid_D_star::Result::success; ++round)
+	{
+		const auto& path = *result.first;
+		if (path.size() <= steps_per_round)
+		{
+			break;
+		}
+		start = path[steps_per_round - 1].state;
+		// Toggle cells around a random point of the remaining path
+		std::uniform_int_distribution<std::size_t> path_dist(steps_per_round, path.size() - 1);
+		const auto center = path[path_dist(re)].state;
+		for (unsigned i = 0; i < toggles_per_round; ++i)
+		{
+			const Grid_pos cell{center.x + offset_dist(re), center.y + offset_dist(re)};
+			if (cell.x < 0 || cell.y < 0 || cell.x >= size || cell.y >= size || cell == start || cell == goal)
+			{
+				continue;
+			}
+			map.set_blocked(cell, map.passable(cell));
+			// The change affects the edges of the cell and, because of corner cutting, the diagonals around it
+			for (std::int32_t dy = -1; dy <= 1; ++dy)
+			{
+				for (std::int32_t dx = -1; dx <= 1; ++dx)
+				{
+					d_star.update(Grid_pos{cell.x + dx, cell.y + dy});
+				}
+			}
+		}
+
+		t0 = std::chrono::steady_clock::now();
+		result = d_star(start, goal);
+		d_star_time += micro(std::chrono::steady_clock::now() - t0);
+		d_star_expansions += d_star.expansions();
+
+		t0 = std::chrono::steady_clock::now();
+		const auto a_star_result = a_star(start, goal);
+		a_star_time += micro(std::chrono::steady_clock::now() - t0);
+
+		const auto cost = path_cost(result);
+		if (std::abs(cost - path_cost(a_star_result)) > 0.001f * std::max(1.0f, cost))
+		{
+			++mismatches;
+		}
+		++completed;
+	}
+
+	std::cout << "Replanning rounds: " << completed << "\n";
+	std::cout << "D* Lite average latency: " << d_star_time / std::max(1u, completed) << " microseconds, "
+			<< d_star_expansions / std::max(1u, completed) << " expansions\n";
+	std::cout << "A* average latency: " << a_star_time / std::max(1u, completed) << " microseconds\n";
+	std::cout << "Rounds with different path cost: " << mismatches << std::endl;
+}
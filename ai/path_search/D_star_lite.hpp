@@ -0,0 +1,391 @@
+#ifndef AI_SEARCHING_D_STAR_LITE_HPP_
+#define AI_SEARCHING_D_STAR_LITE_HPP_
+
+#include "A_star.hpp"
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <cstddef>
+#include <algorithm>
+
+/**
+ * @brief D* Lite: incremental version of A* for graphs whose edge costs change between queries
+ *
+ * The search runs backwards from the goal and keeps g and rhs values of all states between calls,
+ * so after a change only the part of the search affected by it is repaired.
+ * The start can move between calls (e.g. an agent following the path) as long as the goal stays the same.
+ * Edges must be symmetric: the successors of a state are also its predecessors, with the same cost.
+ *
+ * @tparam Generator is a callable returning all successors of a state
+ * @tparam Heuristic is a callable returning the estimated cost of going from a state to another
+ */
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy = Full_result>
+class D_star_lite_search : public Result_policy<State, Action>
+{
+	typedef A_star_search<State, Action, Generator, Heuristic, Result_policy> Search_type;
+public:
+	typedef State State_type;
+	using Result = typename Search_type::Result;
+	using Result_type = typename Search_type::Result_type;
+	D_star_lite_search(const Generator& generator = Generator(), const Heuristic& heuristic = Heuristic())
+	: generator_(generator), heuristic_(heuristic)
+	{}
+	/**
+	 * @brief Finds the cheapest path from start to goal, reusing the previous search if the goal didn't change
+	 */
+	Result_type operator()(State start, State goal);
+	/**
+	 * @brief Notifies that the cost of the edges leaving a state changed
+	 */
+	void update(const State& state) { changed_.push_back(state); }
+	template <typename It>
+	void update(It first, It last) { changed_.insert(changed_.end(), first, last); }
+	/**
+	 * @brief Drops all the information gathered so far
+	 */
+	void reset();
+	/**
+	 * @return Number of states expanded by the last call
+	 */
+	std::size_t expansions() const { return expansions_; }
+private:
+	typedef std::pair<float, float> Key;
+	typedef std::tuple<Key, State> Queue_entry;
+	struct Record
+	{
+		float g = std::numeric_limits<float>::max();
+		float rhs = std::numeric_limits<float>::max();
+		Key key;
+		bool open = false;
+	};
+	struct Queue_compare
+	{
+		bool operator()(const Queue_entry& lhs, const Queue_entry& rhs) const noexcept
+		{
+			return std::get<0>(lhs) > std::get<0>(rhs);
+		}
+	};
+	typedef A_star_node<State, Action> Node;
+	// Binary heap ordered by Queue_compare, a plain vector so that stale entries can be dropped
+	typedef std::vector<Queue_entry> Queue;
+
+	void initialize(const State& start, const State& goal);
+	Key calculate_key(const State& state, const Record& record) const;
+	void update_vertex(const State& state);
+	void update_vertex(const State& state, Record& record);
+	void push(const State& state, Record& record);
+	void compact_queue();
+	void compute_shortest_path();
+	Result_type make_result() const;
+	static float add(float cost, float g) noexcept
+	{
+		return g == std::numeric_limits<float>::max() ? g : cost + g;
+	}
+	/**
+	 * States along the shortest path have the same key as the start. The tolerance makes sure none of them is left
+	 * inconsistent because of rounding, otherwise the path can't be followed through the g values
+	 */
+	static bool precedes_start(const Key& key, const Key& start_key) noexcept
+	{
+		if (start_key.first == std::numeric_limits<float>::max())
+		{
+			return true;
+		}
+		return key.first <= start_key.first + 1e-5f * std::max(1.0f, start_key.first);
+	}
+
+	Generator generator_;
+	Heuristic heuristic_;
+	std::unordered_map<State, Record> records_;
+	Queue queue_;
+	// Number of open records, each has one live entry in the queue
+	std::size_t open_count_ = 0;
+	std::vector<State> changed_;
+	State start_;
+	State goal_;
+	float km_ = 0;
+	bool initialized_ = false;
+	std::size_t expansions_ = 0;
+	// Size of the queue below which stale entries are left alone
+	static constexpr std::size_t min_compaction = 64;
+};
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::operator()(State start, State goal)
+{
+	expansions_ = 0;
+	if (!initialized_ || !(goal == goal_))
+	{
+		initialize(start, goal);
+	}
+	else
+	{
+		if (!(start == start_))
+		{
+			km_ += heuristic_(start_, start);
+			start_ = std::move(start);
+		}
+		for (const auto& state : changed_)
+		{
+			update_vertex(state);
+		}
+	}
+	changed_.clear();
+	compute_shortest_path();
+	return make_result();
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::reset()
+{
+	records_.clear();
+	queue_.clear();
+	open_count_ = 0;
+	changed_.clear();
+	km_ = 0;
+	initialized_ = false;
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::initialize(const State& start,
+		const State& goal)
+{
+	reset();
+	start_ = start;
+	goal_ = goal;
+	initialized_ = true;
+	auto& record = records_[goal_];
+	record.rhs = 0;
+	push(goal_, record);
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::Key
+D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::calculate_key(const State& state,
+		const Record& record) const
+{
+	const float g = std::min(record.g, record.rhs);
+	return {add(heuristic_(state, start_) + km_, g), g};
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::update_vertex(const State& state)
+{
+	update_vertex(state, records_[state]);
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::update_vertex(const State& state,
+		Record& record)
+{
+	if (!(state == goal_))
+	{
+		float rhs = std::numeric_limits<float>::max();
+		for (const auto& successor : generator_(state))
+		{
+			auto it = records_.find(std::get<0>(successor));
+			if (it != records_.end())
+			{
+				rhs = std::min(rhs, add(std::get<2>(successor), it->second.g));
+			}
+		}
+		record.rhs = rhs;
+	}
+	// Entries already in the queue are invalidated lazily by the key check in compute_shortest_path
+	if (record.open)
+	{
+		record.open = false;
+		--open_count_;
+	}
+	if (record.g != record.rhs)
+	{
+		push(state, record);
+	}
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::push(const State& state, Record& record)
+{
+	record.key = calculate_key(state, record);
+	if (!record.open)
+	{
+		record.open = true;
+		++open_count_;
+	}
+	// Stale entries above the start key are never popped: drop them once they outnumber the live ones
+	if (queue_.size() >= 2 * open_count_ + min_compaction)
+	{
+		compact_queue();
+	}
+	queue_.emplace_back(record.key, state);
+	std::push_heap(queue_.begin(), queue_.end(), Queue_compare());
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::compact_queue()
+{
+	// Records are closed while their first live entry is kept, so that a record pushed twice with the same key
+	// keeps one entry
+	const auto live_end = std::remove_if(queue_.begin(), queue_.end(), [this](const Queue_entry& entry)
+			{
+				auto it = records_.find(std::get<1>(entry));
+				if (!it->second.open || it->second.key != std::get<0>(entry))
+				{
+					return true;
+				}
+				it->second.open = false;
+				return false;
+			});
+	queue_.erase(live_end, queue_.end());
+	for (const auto& entry : queue_)
+	{
+		records_.find(std::get<1>(entry))->second.open = true;
+	}
+	std::make_heap(queue_.begin(), queue_.end(), Queue_compare());
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+void D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::compute_shortest_path()
+{
+	while (!queue_.empty())
+	{
+		const auto& start_record = records_[start_];
+		const Key top_key = std::get<0>(queue_.front());
+		if (!precedes_start(top_key, calculate_key(start_, start_record)) && start_record.rhs == start_record.g)
+		{
+			break;
+		}
+		std::pop_heap(queue_.begin(), queue_.end(), Queue_compare());
+		const State state = std::move(std::get<1>(queue_.back()));
+		queue_.pop_back();
+		// References into records_ stay valid while other states are inserted
+		auto& record = records_[state];
+		if (!record.open || record.key != top_key)
+		{
+			// Stale entry
+			continue;
+		}
+		const Key new_key = calculate_key(state, record);
+		if (top_key < new_key)
+		{
+			push(state, record);
+		}
+		else if (record.g > record.rhs)
+		{
+			++expansions_;
+			record.g = record.rhs;
+			record.open = false;
+			--open_count_;
+			for (const auto& predecessor : generator_(state))
+			{
+				update_vertex(std::get<0>(predecessor));
+			}
+		}
+		else
+		{
+			++expansions_;
+			record.g = std::numeric_limits<float>::max();
+			for (const auto& predecessor : generator_(state))
+			{
+				update_vertex(std::get<0>(predecessor));
+			}
+			update_vertex(state, record);
+		}
+	}
+}
+
+template <typename State,
+		typename Action,
+		typename Generator,
+		typename Heuristic,
+		template <typename, typename> class Result_policy>
+typename D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::Result_type
+D_star_lite_search<State, Action, Generator, Heuristic, Result_policy>::make_result() const
+{
+	auto it = records_.find(start_);
+	if (it == records_.end() || it->second.g == std::numeric_limits<float>::max())
+	{
+		return std::make_pair(typename Result_policy<State, Action>::Result_type(), Result::failure);
+	}
+	// Nodes are linked through parent pointers, so the vector must not reallocate
+	std::vector<Node> path;
+	path.reserve(records_.size() + 1);
+	path.emplace_back(heuristic_(start_, goal_), 0, start_, Action(), nullptr);
+	while (!(path.back().state == goal_))
+	{
+		const Node& node = path.back();
+		const auto successors = generator_(node.state);
+		auto best = successors.cend();
+		float best_cost = std::numeric_limits<float>::max();
+		for (auto successor_it = successors.cbegin(); successor_it != successors.cend(); ++successor_it)
+		{
+			auto record_it = records_.find(std::get<0>(*successor_it));
+			if (record_it != records_.end())
+			{
+				const float cost = add(std::get<2>(*successor_it), record_it->second.g);
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best = successor_it;
+				}
+			}
+		}
+		if (best == successors.cend() || path.size() > records_.size())
+		{
+			return std::make_pair(typename Result_policy<State, Action>::Result_type(), Result::failure);
+		}
+		const float g_cost = node.g_cost + std::get<2>(*best);
+		path.emplace_back(g_cost + heuristic_(std::get<0>(*best), goal_),
+				g_cost,
+				std::get<0>(*best),
+				std::get<1>(*best),
+				&node);
+	}
+	return std::make_pair(std::move(Result_policy<State, Action>::make_path(path.back())), Result::success);
+}
+
+#endif
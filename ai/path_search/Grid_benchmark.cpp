@@ -0,0 +1,125 @@
+/**
+	Compares plain A* and A* with jump point search on a large grid map.
+	Usage: Grid_benchmark [number of queries] [map file]
+	Without a map file a 4096x4096 map scattered with random rectangular obstacles is generated.
+ */
+
+#include "A_star.hpp"
+#include "Grid_map.hpp"
+#include "Jump_point_search.hpp"
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+typedef A_star_search<Grid_pos, Grid_action, Grid_successors_gen, Grid_heuristic_octile, Full_result> Grid_A_star;
+typedef A_star_search<Grid_pos, Grid_action, Jump_point_generator, Grid_heuristic_octile, Full_result> Grid_JPS;
+typedef std::vector<std::pair<Grid_pos, Grid_pos>> Queries;
+
+Grid_map make_synthetic_map(std::int32_t size, std::mt19937& re);
+Queries make_queries(const Grid_map& map, unsigned n, std::mt19937& re);
+template <typename Solver> std::vector<float> run_queries(const char* name, const Solver& solver, const Queries& queries);
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 re(42);
+	const unsigned num_queries = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20;
+	const Grid_map map = (argc > 2) ? load_grid_map(argv[2]) : make_synthetic_map(4096, re);
+	std::cout << "Map size: " << map.width() << "x" << map.height() << "\n";
+	const auto queries = make_queries(map, num_queries, re);
+
+	const auto jps_costs = run_queries("A* with jump point search", Grid_JPS(Jump_point_generator(map)), queries);
+	const auto a_star_costs = run_queries("A*", Grid_A_star(Grid_successors_gen(map)), queries);
+	unsigned mismatches = 0;
+	for (std::size_t i = 0; i < queries.size(); ++i)
+	{
+		if (std::abs(jps_costs[i] - a_star_costs[i]) > 0.01f * a_star_costs[i])
+		{
+			++mismatches;
+		}
+	}
+	std::cout << "Queries with different path cost: " << mismatches << std::endl;
+}
+
+Grid_map make_synthetic_map(std::int32_t size, std::mt19937& re)
+{
+	Grid_map map(size, size);
+	std::uniform_int_distribution<std::int32_t> pos_dist(0, size - 1);
+	std::uniform_int_distribution<std::int32_t> side_dist(1, size / 64);
+	const std::int32_t num_obstacles = size;
+	for (std::int32_t i = 0; i < num_obstacles; ++i)
+	{
+		const auto x0 = pos_dist(re);
+		const auto y0 = pos_dist(re);
+		const auto x1 = std::min(size, x0 + side_dist(re));
+		const auto y1 = std::min(size, y0 + side_dist(re));
+		for (auto y = y0; y < y1; ++y)
+		{
+			for (auto x = x0; x < x1; ++x)
+			{
+				map.set_blocked(x, y);
+			}
+		}
+	}
+	return map;
+}
+
+Queries make_queries(const Grid_map& map, unsigned n, std::mt19937& re)
+{
+	std::uniform_int_distribution<std::int32_t> x_dist(0, map.width() - 1);
+	std::uniform_int_distribution<std::int32_t> y_dist(0, map.height() - 1);
+	auto random_cell = [&]()
+			{
+				Grid_pos pos;
+				do
+				{
+					pos = Grid_pos{x_dist(re), y_dist(re)};
+				}
+				while (!map.passable(pos));
+				return pos;
+			};
+	Queries queries;
+	for (unsigned i = 0; i < n; ++i)
+	{
+		const auto start = random_cell();
+		queries.emplace_back(start, random_cell());
+	}
+	return queries;
+}
+
+template <typename Solver>
+std::vector<float> run_queries(const char* name, const Solver& solver, const Queries& queries)
+{
+	std::vector<float> costs;
+	unsigned failures = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (const auto& query : queries)
+	{
+		auto result = solver(query.first, query.second);
+		if (result.second == Solver::Result::success)
+		{
+			costs.push_back(result.first->empty() ? 0.0f : result.first->back().g_cost);
+		}
+		else
+		{
+			costs.push_back(-1.0f);
+			++failures;
+		}
+	}
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	float total_cost = 0;
+	for (auto cost : costs)
+	{
+		total_cost += std::max(cost, 0.0f);
+	}
+	std::cout << "--- " << name << "\n";
+	std::cout << "Queries: " << queries.size() << " (" << failures << " without a path)\n";
+	std::cout << "Average path cost: " << total_cost / std::max<std::size_t>(1, queries.size() - failures) << "\n";
+	std::cout << "Queries per second: " << queries.size() * 1e6 / std::max<long long>(1, duration.count()) << "\n";
+	return costs;
+}
@@ -0,0 +1,208 @@
+#include "Grid_map.hpp"
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRID_MAP_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+	/**
+	 * Read-only view over the whole content of a file
+	 */
+	class File_view
+	{
+	public:
+		explicit File_view(const std::string& path);
+		~File_view();
+		File_view(const File_view&) = delete;
+		File_view& operator=(const File_view&) = delete;
+		const char* begin() const { return data_; }
+		const char* end() const { return data_ + size_; }
+	private:
+		const char* data_ = nullptr;
+		std::size_t size_ = 0;
+#ifdef GRID_MAP_USE_MMAP
+		void* mapping_ = nullptr;
+#else
+		std::string buffer_;
+#endif
+	};
+
+	class Map_parser
+	{
+	public:
+		Map_parser(const char* begin, const char* end) : it_(begin), end_(end) {}
+		Grid_map parse();
+	private:
+		std::string next_token();
+		std::string next_line();
+
+		const char* it_;
+		const char* end_;
+	};
+
+	bool is_passable_terrain(char c)
+	{
+		return c == '.' || c == 'G' || c == 'S';
+	}
+
+}
+
+Grid_map load_grid_map(const std::string& path)
+{
+	File_view file(path);
+	return Map_parser(file.begin(), file.end()).parse();
+}
+
+namespace
+{
+
+#ifdef GRID_MAP_USE_MMAP
+	File_view::File_view(const std::string& path)
+	{
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			throw std::runtime_error("can't open map file " + path);
+		}
+		struct stat st;
+		if (::fstat(fd, &st) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("can't read map file " + path);
+		}
+		size_ = static_cast<std::size_t>(st.st_size);
+		if (size_ > 0)
+		{
+			mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		::close(fd);
+		if (mapping_ == MAP_FAILED)
+		{
+			throw std::runtime_error("can't map file " + path);
+		}
+		data_ = static_cast<const char*>(mapping_);
+	}
+
+	File_view::~File_view()
+	{
+		if (mapping_ != nullptr)
+		{
+			::munmap(mapping_, size_);
+		}
+	}
+#else
+	File_view::File_view(const std::string& path)
+	{
+		std::ifstream is(path, std::ios::binary);
+		if (!is)
+		{
+			throw std::runtime_error("can't open map file " + path);
+		}
+		buffer_.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+		data_ = buffer_.data();
+		size_ = buffer_.size();
+	}
+
+	File_view::~File_view() = default;
+#endif
+
+	Grid_map Map_parser::parse()
+	{
+		long width = -1;
+		long height = -1;
+		while (true)
+		{
+			const auto key = next_token();
+			if (key.empty())
+			{
+				throw std::runtime_error("map file has no 'map' section");
+			}
+			if (key == "map")
+			{
+				break;
+			}
+			const auto value = next_token();
+			if (key == "width")
+			{
+				width = std::strtol(value.c_str(), nullptr, 10);
+			}
+			else if (key == "height")
+			{
+				height = std::strtol(value.c_str(), nullptr, 10);
+			}
+		}
+		if (width <= 0 || height <= 0)
+		{
+			throw std::runtime_error("map file has invalid size");
+		}
+		next_line();
+
+		Grid_map map(static_cast<std::int32_t>(width), static_cast<std::int32_t>(height));
+		for (std::int32_t y = 0; y < height; ++y)
+		{
+			const auto row_begin = it_;
+			const auto row_end = static_cast<const char*>(std::memchr(it_, '\n', end_ - it_));
+			it_ = (row_end == nullptr) ? end_ : row_end + 1;
+			auto row_size = ((row_end == nullptr) ? end_ : row_end) - row_begin;
+			if (row_size > 0 && row_begin[row_size - 1] == '\r')
+			{
+				--row_size;
+			}
+			if (row_size < width)
+			{
+				throw std::runtime_error("map file has a truncated row");
+			}
+			for (std::int32_t x = 0; x < width; ++x)
+			{
+				if (!is_passable_terrain(row_begin[x]))
+				{
+					map.set_blocked(x, y);
+				}
+			}
+		}
+		return map;
+	}
+
+	std::string Map_parser::next_token()
+	{
+		while (it_ != end_ && std::isspace(static_cast<unsigned char>(*it_)))
+		{
+			++it_;
+		}
+		const auto begin = it_;
+		while (it_ != end_ && !std::isspace(static_cast<unsigned char>(*it_)))
+		{
+			++it_;
+		}
+		return std::string(begin, it_);
+	}
+
+	std::string Map_parser::next_line()
+	{
+		const auto begin = it_;
+		while (it_ != end_ && *it_ != '\n')
+		{
+			++it_;
+		}
+		std::string line(begin, it_);
+		if (it_ != end_)
+		{
+			++it_;
+		}
+		return line;
+	}
+
+}
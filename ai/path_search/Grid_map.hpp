@@ -0,0 +1,242 @@
+#ifndef AI_SEARCHING_GRID_MAP_HPP_
+#define AI_SEARCHING_GRID_MAP_HPP_
+
+#include <vector>
+#include <string>
+#include <tuple>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+/**
+ * @brief Coordinates of a cell in a grid map
+ */
+struct Grid_pos
+{
+	std::int32_t x;
+	std::int32_t y;
+};
+
+inline bool operator==(Grid_pos lhs, Grid_pos rhs) noexcept
+{
+	return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+inline bool operator!=(Grid_pos lhs, Grid_pos rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
+inline std::ostream& operator<<(std::ostream& os, Grid_pos pos)
+{
+	os << "(" << pos.x << ", " << pos.y << ")";
+	return os;
+}
+
+namespace std
+{
+
+	template <>
+	struct hash<Grid_pos>
+	{
+		std::size_t operator()(Grid_pos pos) const noexcept
+		{
+			const std::uint64_t key = static_cast<std::uint64_t>(static_cast<std::uint32_t>(pos.y)) << 32 |
+					static_cast<std::uint32_t>(pos.x);
+			// A narrower size_t takes the high bits of a multiplicative hash, which depend on both coordinates
+			return sizeof(std::size_t) < sizeof(key) ?
+					static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) :
+					static_cast<std::size_t>(key);
+		}
+	};
+
+}
+
+/**
+ * @brief Direction of a move between two grid cells (y grows towards south)
+ */
+struct Grid_action
+{
+	enum Type : char
+	{
+		IDLE, N, NE, E, SE, S, SW, W, NW
+	};
+
+	Grid_action() = default;
+	Grid_action(Type type) : value(type) {}
+	inline Grid_action get_reverse() const;
+	inline int dx() const noexcept;
+	inline int dy() const noexcept;
+	inline static Grid_action from_delta(int dx, int dy) noexcept;
+
+	Type value = IDLE;
+};
+
+Grid_action Grid_action::get_reverse() const
+{
+	return value == IDLE ? Grid_action(IDLE) : Grid_action(static_cast<Type>((value + 3) % 8 + 1));
+}
+
+int Grid_action::dx() const noexcept
+{
+	static const int table[] = {0, 0, 1, 1, 1, 0, -1, -1, -1};
+	return table[value];
+}
+
+int Grid_action::dy() const noexcept
+{
+	static const int table[] = {0, -1, -1, 0, 1, 1, 1, 0, -1};
+	return table[value];
+}
+
+Grid_action Grid_action::from_delta(int dx, int dy) noexcept
+{
+	static const Type table[3][3] = {{NW, W, SW}, {N, IDLE, S}, {NE, E, SE}};
+	return Grid_action(table[(dx > 0) - (dx < 0) + 1][(dy > 0) - (dy < 0) + 1]);
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Grid_action& rhs)
+{
+	static const char* const names[] = {"IDLE", "N", "NE", "E", "SE", "S", "SW", "W", "NW"};
+	os << names[rhs.value];
+	return os;
+}
+
+/**
+ * @brief Occupancy grid storing one bit per cell, rows are padded to 64 bits
+ *
+ * Cells outside the map are reported as blocked.
+ */
+class Grid_map
+{
+public:
+	typedef std::uint64_t Word;
+
+	Grid_map(std::int32_t width, std::int32_t height)
+	: width_(width),
+			height_(height),
+			words_per_row_((static_cast<std::size_t>(width) + word_bits - 1) / word_bits),
+			bits_(words_per_row_ * height, 0)
+	{}
+	std::int32_t width() const noexcept { return width_; }
+	std::int32_t height() const noexcept { return height_; }
+	bool passable(std::int32_t x, std::int32_t y) const noexcept
+	{
+		if (x < 0 || y < 0 || x >= width_ || y >= height_)
+		{
+			return false;
+		}
+		return !((bits_[word_index(x, y)] >> (x % word_bits)) & 1);
+	}
+	bool passable(Grid_pos pos) const noexcept { return passable(pos.x, pos.y); }
+	void set_blocked(std::int32_t x, std::int32_t y, bool blocked = true) noexcept
+	{
+		const Word mask = Word(1) << (x % word_bits);
+		if (blocked)
+		{
+			bits_[word_index(x, y)] |= mask;
+		}
+		else
+		{
+			bits_[word_index(x, y)] &= ~mask;
+		}
+	}
+	void set_blocked(Grid_pos pos, bool blocked = true) noexcept { set_blocked(pos.x, pos.y, blocked); }
+	/**
+	 * Diagonal moves are allowed only if both the adjacent straight cells are passable (no corner cutting)
+	 */
+	bool can_move(std::int32_t x, std::int32_t y, int dx, int dy) const noexcept
+	{
+		if (!passable(x + dx, y + dy))
+		{
+			return false;
+		}
+		return dx == 0 || dy == 0 || (passable(x + dx, y) && passable(x, y + dy));
+	}
+private:
+	static constexpr std::size_t word_bits = 64;
+	std::size_t word_index(std::int32_t x, std::int32_t y) const noexcept
+	{
+		return static_cast<std::size_t>(y) * words_per_row_ + static_cast<std::size_t>(x) / word_bits;
+	}
+
+	std::int32_t width_;
+	std::int32_t height_;
+	std::size_t words_per_row_;
+	std::vector<Word> bits_;
+};
+
+/**
+ * @brief Loads a map in the common text format used by grid pathfinding benchmarks
+ *
+ * The header lists 'type', 'height' and 'width' and is followed by the 'map' keyword and one line per row.
+ * Cells marked with '.', 'G' or 'S' are passable, everything else is blocked.
+ * On POSIX systems the file is memory-mapped instead of read into a buffer.
+ *
+ * @throw std::runtime_error if the file can't be opened or is malformed
+ */
+Grid_map load_grid_map(const std::string& path);
+
+namespace detail
+{
+
+	constexpr float grid_diagonal_cost = 1.41421356f;
+
+	inline float octile_distance(Grid_pos from, Grid_pos to) noexcept
+	{
+		const auto dx = std::abs(from.x - to.x);
+		const auto dy = std::abs(from.y - to.y);
+		return std::max(dx, dy) + (grid_diagonal_cost - 1.0f) * std::min(dx, dy);
+	}
+
+}
+
+/**
+ * @brief Generates all the cells reachable with one move in the eight directions
+ *
+ * Edges are symmetric, blocked cells have no successors.
+ */
+class Grid_successors_gen
+{
+public:
+	typedef std::tuple<Grid_pos, Grid_action, float> Successor;
+	explicit Grid_successors_gen(const Grid_map& map) : map_(&map) {}
+	std::vector<Successor> operator()(const Grid_pos& pos) const
+	{
+		std::vector<Successor> v;
+		if (!map_->passable(pos))
+		{
+			return v;
+		}
+		v.reserve(8);
+		for (char type = Grid_action::N; type <= Grid_action::NW; ++type)
+		{
+			const Grid_action action(static_cast<Grid_action::Type>(type));
+			if (map_->can_move(pos.x, pos.y, action.dx(), action.dy()))
+			{
+				v.emplace_back(Grid_pos{pos.x + action.dx(), pos.y + action.dy()},
+						action,
+						(action.dx() != 0 && action.dy() != 0) ? detail::grid_diagonal_cost : 1.0f);
+			}
+		}
+		return v;
+	}
+private:
+	const Grid_map* map_;
+};
+
+/**
+ * @brief Octile distance, admissible and consistent for eight-connected grids
+ */
+struct Grid_heuristic_octile
+{
+	float operator()(const Grid_pos& state, const Grid_pos& goal) const noexcept
+	{
+		return detail::octile_distance(state, goal);
+	}
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef AI_SEARCHING_JUMP_POINT_SEARCH_HPP_
+#define AI_SEARCHING_JUMP_POINT_SEARCH_HPP_
+
+#include "Grid_map.hpp"
+#include <vector>
+#include <tuple>
+#include <cstdint>
+
+/**
+ * @brief Successor generator for A* implementing jump point search on uniform-cost grids
+ *
+ * Neighbours are pruned according to the direction of the move that reached the current cell,
+ * then the search 'jumps' along each remaining direction until it finds a cell with a forced neighbour
+ * or the goal. Only these jump points enter the frontier, so the symmetric paths of open areas are never expanded.
+ * Uses the same movement rules as Grid_successors_gen, therefore A* still returns optimal paths.
+ */
+class Jump_point_generator
+{
+public:
+	typedef std::tuple<Grid_pos, Grid_action, float> Successor;
+	explicit Jump_point_generator(const Grid_map& map) : map_(&map) {}
+	std::vector<Successor> operator()(const Grid_pos& pos, const Grid_action& action, const Grid_pos& goal) const;
+private:
+	void add_jump(std::vector<Successor>& v, Grid_pos pos, int dx, int dy, Grid_pos goal) const;
+	bool jump(Grid_pos& pos, int dx, int dy, Grid_pos goal) const;
+	bool jump_straight(Grid_pos& pos, int dx, int dy, Grid_pos goal) const;
+	bool passable(std::int32_t x, std::int32_t y) const noexcept { return map_->passable(x, y); }
+
+	const Grid_map* map_;
+};
+
+inline std::vector<Jump_point_generator::Successor> Jump_point_generator::operator()(const Grid_pos& pos,
+		const Grid_action& action,
+		const Grid_pos& goal) const
+{
+	std::vector<Successor> v;
+	const int dx = action.dx();
+	const int dy = action.dy();
+	const auto x = pos.x;
+	const auto y = pos.y;
+	if (action.value == Grid_action::IDLE)
+	{
+		for (char type = Grid_action::N; type <= Grid_action::NW; ++type)
+		{
+			const Grid_action direction(static_cast<Grid_action::Type>(type));
+			if (map_->can_move(x, y, direction.dx(), direction.dy()))
+			{
+				add_jump(v, pos, direction.dx(), direction.dy(), goal);
+			}
+		}
+	}
+	else if (dx != 0 && dy != 0)
+	{
+		const bool horizontal = passable(x + dx, y);
+		const bool vertical = passable(x, y + dy);
+		if (vertical)
+		{
+			add_jump(v, pos, 0, dy, goal);
+		}
+		if (horizontal)
+		{
+			add_jump(v, pos, dx, 0, goal);
+		}
+		if (horizontal && vertical && passable(x + dx, y + dy))
+		{
+			add_jump(v, pos, dx, dy, goal);
+		}
+	}
+	else
+	{
+		// Sides are perpendicular to the direction of movement
+		const int sx = dy;
+		const int sy = dx;
+		const bool next = passable(x + dx, y + dy);
+		const bool side_1 = passable(x + sx, y + sy);
+		const bool side_2 = passable(x - sx, y - sy);
+		if (next)
+		{
+			add_jump(v, pos, dx, dy, goal);
+			if (side_1 && passable(x + dx + sx, y + dy + sy))
+			{
+				add_jump(v, pos, dx + sx, dy + sy, goal);
+			}
+			if (side_2 && passable(x + dx - sx, y + dy - sy))
+			{
+				add_jump(v, pos, dx - sx, dy - sy, goal);
+			}
+		}
+		if (side_1)
+		{
+			add_jump(v, pos, sx, sy, goal);
+		}
+		if (side_2)
+		{
+			add_jump(v, pos, -sx, -sy, goal);
+		}
+	}
+	return v;
+}
+
+inline void Jump_point_generator::add_jump(std::vector<Successor>& v,
+		Grid_pos pos,
+		int dx,
+		int dy,
+		Grid_pos goal) const
+{
+	const Grid_pos from = pos;
+	if (jump(pos, dx, dy, goal))
+	{
+		v.emplace_back(pos, Grid_action::from_delta(dx, dy), detail::octile_distance(from, pos));
+	}
+}
+
+/**
+ * Moves pos along (dx, dy) until a jump point is found
+ *
+ * @return False if the jump hits an obstacle without finding any jump point
+ */
+inline bool Jump_point_generator::jump(Grid_pos& pos, int dx, int dy, Grid_pos goal) const
+{
+	if (dx == 0 || dy == 0)
+	{
+		return jump_straight(pos, dx, dy, goal);
+	}
+	while (map_->can_move(pos.x, pos.y, dx, dy))
+	{
+		pos.x += dx;
+		pos.y += dy;
+		if (pos == goal)
+		{
+			return true;
+		}
+		// A diagonal cell is a jump point if any of its straight projections reaches one
+		Grid_pos straight = pos;
+		if (jump_straight(straight, dx, 0, goal))
+		{
+			return true;
+		}
+		straight = pos;
+		if (jump_straight(straight, 0, dy, goal))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+inline bool Jump_point_generator::jump_straight(Grid_pos& pos, int dx, int dy, Grid_pos goal) const
+{
+	const int sx = dy;
+	const int sy = dx;
+	auto x = pos.x;
+	auto y = pos.y;
+	while (passable(x + dx, y + dy))
+	{
+		x += dx;
+		y += dy;
+		if ((x == goal.x && y == goal.y) ||
+				(passable(x + sx, y + sy) && !passable(x - dx + sx, y - dy + sy)) ||
+				(passable(x - sx, y - sy) && !passable(x - dx - sx, y - dy - sy)))
+		{
+			pos = Grid_pos{x, y};
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef AI_SEARCHING_SEARCH_CHECKPOINT_HPP_
+#define AI_SEARCHING_SEARCH_CHECKPOINT_HPP_
+
+#include <string>
+#include <fstream>
+#include <future>
+#include <chrono>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief Binary serialization of the states and actions stored in a checkpoint
+ *
+ * Trivially copyable types are stored as raw bytes, other types need a specialization.
+ */
+template <typename T>
+struct Checkpoint_traits
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+			"Checkpoint_traits must be specialized for types that aren't trivially copyable");
+	static void write(std::ostream& os, const T& value)
+	{
+		os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	static void read(std::istream& is, T& value)
+	{
+		is.read(reinterpret_cast<char*>(&value), sizeof(T));
+	}
+};
+
+namespace detail
+{
+
+	template <typename T>
+	inline void checkpoint_write(std::ostream& os, const T& value)
+	{
+		Checkpoint_traits<T>::write(os, value);
+	}
+
+	template <typename T>
+	inline T checkpoint_read(std::istream& is)
+	{
+		T value;
+		Checkpoint_traits<T>::read(is, value);
+		if (!is)
+		{
+			throw std::runtime_error("checkpoint is truncated");
+		}
+		return value;
+	}
+
+	inline void checkpoint_write_header(std::ostream& os, const char (&magic)[9])
+	{
+		os.write(magic, 8);
+	}
+
+	inline void checkpoint_check_header(std::istream& is, const char (&magic)[9])
+	{
+		char buffer[8];
+		if (!is.read(buffer, 8) || std::memcmp(buffer, magic, 8) != 0)
+		{
+			throw std::runtime_error("not a checkpoint of this kind of search");
+		}
+	}
+
+}
+
+/**
+ * @brief Periodically writes snapshots of a search to a file
+ *
+ * The search thread only takes a cheap snapshot of its state; serialization and file output run on a
+ * background thread. Each checkpoint is written to a temporary file which then replaces the previous one,
+ * so a crash during a write never leaves a corrupted checkpoint behind.
+ */
+class Checkpoint_writer
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	Checkpoint_writer(std::string path, Clock::duration interval)
+	: path_(std::move(path)), interval_(interval), next_(Clock::now() + interval)
+	{}
+	Checkpoint_writer(const Checkpoint_writer&) = delete;
+	Checkpoint_writer& operator=(const Checkpoint_writer&) = delete;
+	~Checkpoint_writer()
+	{
+		if (pending_.valid())
+		{
+			pending_.wait();
+		}
+	}
+	const std::string& path() const noexcept { return path_; }
+	/**
+	 * @return True if it's time to take a new snapshot
+	 */
+	bool due() const noexcept { return Clock::now() >= next_; }
+	/**
+	 * @brief Hands a snapshot over to the background thread, which writes it with serializer(stream, snapshot)
+	 *
+	 * If the previous checkpoint is still being written the snapshot is dropped and a new one will be due
+	 * at the next check. Errors of the previous write are rethrown here.
+	 */
+	template <typename Snapshot, typename Serializer>
+	void save(Snapshot&& snapshot, Serializer serializer);
+	/**
+	 * @brief Waits for the checkpoint being written, rethrowing its errors
+	 */
+	void wait()
+	{
+		if (pending_.valid())
+		{
+			pending_.get();
+		}
+	}
+	/**
+	 * @return Number of checkpoints written so far
+	 */
+	unsigned written() const noexcept { return written_; }
+private:
+	static void commit(const std::string& temp_path, const std::string& path)
+	{
+		if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+		{
+			// Some platforms don't replace existing files on rename
+			std::remove(path.c_str());
+			if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+			{
+				throw std::runtime_error("can't write checkpoint " + path);
+			}
+		}
+	}
+
+	std::string path_;
+	Clock::duration interval_;
+	Clock::time_point next_;
+	std::future<void> pending_;
+	unsigned written_ = 0;
+};
+
+template <typename Snapshot, typename Serializer>
+void Checkpoint_writer::save(Snapshot&& snapshot, Serializer serializer)
+{
+	if (pending_.valid())
+	{
+		if (pending_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return;
+		}
+		pending_.get();
+	}
+	next_ = Clock::now() + interval_;
+	++written_;
+	pending_ = std::async(std::launch::async,
+			[path = path_, serializer, snapshot = std::forward<Snapshot>(snapshot)]()
+			{
+				const std::string temp_path = path + ".tmp";
+				{
+					std::ofstream os(temp_path, std::ios::binary | std::ios::trunc);
+					serializer(os, snapshot);
+					os.flush();
+					if (!os)
+					{
+						throw std::runtime_error("can't write checkpoint " + temp_path);
+					}
+				}
+				commit(temp_path, path);
+			});
+}
+
+#endif
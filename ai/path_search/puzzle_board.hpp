@@ -250,7 +250,6 @@ inline void hash_combine(std::size_t& seed, const T& v) noexcept
 namespace std
 {
 
-	template <>
 	template <signed char N>
 	struct hash<Puzzle_board<N>>
 	{
@@ -0,0 +1,258 @@
+#ifndef CONCURRENCY_MPMC_QUEUE_HPP_
+#define CONCURRENCY_MPMC_QUEUE_HPP_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+/**
+ * @brief Bounded lock-free queue for multiple producers and consumers (Dmitry Vyukov's algorithm)
+ *
+ * Values are stored in a ring of cells allocated once; the sequence number of each cell tells whether it
+ * can be written or read at the current position, so producers and consumers only compete on their own
+ * position counter. try_push and try_pop never block; push and pop wait when the queue is full or empty,
+ * which gives backpressure to producers faster than their consumers.
+ */
+template <typename T>
+class Mpmc_queue
+{
+public:
+	/**
+	 * @param capacity maximum number of values, rounded up to a power of two
+	 */
+	explicit Mpmc_queue(std::size_t capacity = 1024);
+	Mpmc_queue(const Mpmc_queue&) = delete;
+	Mpmc_queue& operator=(const Mpmc_queue&) = delete;
+	~Mpmc_queue();
+	std::size_t capacity() const noexcept { return mask_ + 1; }
+	/**
+	 * @return False if the queue is full, value is then left untouched
+	 */
+	bool try_push(T& value) { return try_emplace(std::move(value)); }
+	bool try_push(T&& value) { return try_emplace(std::move(value)); }
+	/**
+	 * @return False if the queue is empty
+	 */
+	bool try_pop(T& value);
+	/**
+	 * @brief Waits until there is room for the value
+	 */
+	void push(T value);
+	/**
+	 * @brief Waits until a value is available
+	 */
+	void pop(T& value);
+	/**
+	 * @return True if the queue looked empty at some point during the call
+	 */
+	bool empty() const noexcept
+	{
+		return dequeue_pos_.load(std::memory_order_acquire) >= enqueue_pos_.load(std::memory_order_acquire);
+	}
+	/**
+	 * @return True if the queue looked full at some point during the call
+	 */
+	bool full() const noexcept
+	{
+		return enqueue_pos_.load(std::memory_order_acquire) - dequeue_pos_.load(std::memory_order_acquire) > mask_;
+	}
+private:
+	static constexpr std::size_t cache_line = 64;
+	// Failed attempts before a blocking operation goes to sleep
+	static constexpr unsigned spins = 64;
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+	};
+	/**
+	 * Threads sleeping until the queue changes state. Sleepers register under the mutex before checking the
+	 * queue a last time, the other side checks for sleepers after its operation.
+	 */
+	struct Waiters
+	{
+		/**
+		 * Retries operation until it succeeds, sleeping while blocked() is true.
+		 * The operation runs without holding the mutex, since it notifies the opposite waiters
+		 */
+		template <typename Operation, typename Blocked>
+		void wait_until(Operation operation, Blocked blocked);
+		void notify()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (count.load(std::memory_order_relaxed) != 0)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				cond.notify_all();
+			}
+		}
+		std::atomic<unsigned> count{0};
+		std::mutex mutex;
+		std::condition_variable cond;
+	};
+	template <typename Arg>
+	bool try_emplace(Arg&& value);
+
+	const std::size_t mask_;
+	const std::unique_ptr<Cell[]> cells_;
+	alignas(cache_line) std::atomic<std::size_t> enqueue_pos_;
+	alignas(cache_line) std::atomic<std::size_t> dequeue_pos_;
+	alignas(cache_line) Waiters not_full_;
+	Waiters not_empty_;
+};
+
+namespace detail
+{
+
+	inline std::size_t round_up_to_power_of_two(std::size_t n) noexcept
+	{
+		std::size_t power = 1;
+		while (power < n)
+		{
+			power <<= 1;
+		}
+		return power;
+	}
+
+}
+
+template <typename T>
+Mpmc_queue<T>::Mpmc_queue(std::size_t capacity)
+: mask_(detail::round_up_to_power_of_two(capacity < 2 ? 2 : capacity) - 1),
+		cells_(new Cell[mask_ + 1]),
+		enqueue_pos_(0),
+		dequeue_pos_(0)
+{
+	for (std::size_t i = 0; i <= mask_; ++i)
+	{
+		cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+template <typename T>
+Mpmc_queue<T>::~Mpmc_queue()
+{
+	const auto last = enqueue_pos_.load(std::memory_order_relaxed);
+	for (auto pos = dequeue_pos_.load(std::memory_order_relaxed); pos != last; ++pos)
+	{
+		reinterpret_cast<T*>(&cells_[pos & mask_].storage)->~T();
+	}
+}
+
+template <typename T>
+template <typename Arg>
+bool Mpmc_queue<T>::try_emplace(Arg&& value)
+{
+	Cell* cell;
+	std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+	while (true)
+	{
+		cell = &cells_[pos & mask_];
+		const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+		if (diff == 0)
+		{
+			if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The cell still holds the value written one lap ago
+			return false;
+		}
+		else
+		{
+			pos = enqueue_pos_.load(std::memory_order_relaxed);
+		}
+	}
+	new (&cell->storage) T(std::forward<Arg>(value));
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	not_empty_.notify();
+	return true;
+}
+
+template <typename T>
+bool Mpmc_queue<T>::try_pop(T& value)
+{
+	Cell* cell;
+	std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+	while (true)
+	{
+		cell = &cells_[pos & mask_];
+		const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+		if (diff == 0)
+		{
+			if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = dequeue_pos_.load(std::memory_order_relaxed);
+		}
+	}
+	T* stored = reinterpret_cast<T*>(&cell->storage);
+	value = std::move(*stored);
+	stored->~T();
+	cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+	not_full_.notify();
+	return true;
+}
+
+template <typename T>
+template <typename Operation, typename Blocked>
+void Mpmc_queue<T>::Waiters::wait_until(Operation operation, Blocked blocked)
+{
+	for (unsigned i = 0; i < spins; ++i)
+	{
+		if (operation())
+		{
+			return;
+		}
+		std::this_thread::yield();
+	}
+	while (!operation())
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		count.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (blocked())
+		{
+			cond.wait(lock);
+		}
+		count.fetch_sub(1, std::memory_order_relaxed);
+		lock.unlock();
+		// Not blocked but the operation failed: another thread is completing a push or a pop on the same cell
+		std::this_thread::yield();
+	}
+}
+
+template <typename T>
+void Mpmc_queue<T>::push(T value)
+{
+	not_full_.wait_until([this, &value]() { return try_emplace(std::move(value)); },
+			[this]() { return full(); });
+}
+
+template <typename T>
+void Mpmc_queue<T>::pop(T& value)
+{
+	not_empty_.wait_until([this, &value]() { return try_pop(value); },
+			[this]() { return empty(); });
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <future>
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include "Mpmc_queue.hpp"
+
+// Every value carries its producer, so that consumers can check the order of each producer
+struct Value
+{
+	unsigned producer;
+	unsigned i;
+};
+
+void produce(Mpmc_queue<Value>& queue, unsigned producer, unsigned count)
+{
+	for (unsigned i = 0; i < count; ++i)
+	{
+		queue.push(Value{producer, i});
+	}
+}
+
+std::vector<Value> consume(Mpmc_queue<Value>& queue, std::atomic<int>& remaining)
+{
+	std::vector<Value> values;
+	Value value;
+	// A consumer claims a value before popping it, so that no one waits for a value which won't come
+	while (remaining.fetch_sub(1) > 0)
+	{
+		queue.pop(value);
+		values.push_back(value);
+	}
+	return values;
+}
+
+void test(unsigned producers, unsigned consumers, unsigned count, std::size_t capacity)
+{
+	Mpmc_queue<Value> queue(capacity);
+	std::atomic<int> remaining{static_cast<int>(producers * count)};
+	std::vector<std::future<std::vector<Value>>> futures;
+	std::vector<std::future<void>> producer_futures;
+	for (unsigned i = 0; i < consumers; ++i)
+	{
+		futures.push_back(std::async(std::launch::async, consume, std::ref(queue), std::ref(remaining)));
+	}
+	for (unsigned i = 0; i < producers; ++i)
+	{
+		producer_futures.push_back(std::async(std::launch::async, produce, std::ref(queue), i, count));
+	}
+	for (auto& future : producer_futures)
+	{
+		future.get();
+	}
+
+	std::vector<unsigned> received;
+	bool ordered = true;
+	for (auto& future : futures)
+	{
+		std::vector<unsigned> last(producers, 0);
+		std::vector<bool> seen(producers, false);
+		for (const auto& value : future.get())
+		{
+			ordered = ordered && (!seen[value.producer] || last[value.producer] < value.i);
+			seen[value.producer] = true;
+			last[value.producer] = value.i;
+			received.push_back(value.producer * count + value.i);
+		}
+	}
+	std::sort(received.begin(), received.end());
+	std::vector<unsigned> expected(producers * count);
+	std::iota(expected.begin(), expected.end(), 0);
+
+	std::cout << producers << " producers, " << consumers << " consumers, capacity " << queue.capacity() << std::endl;
+	std::cout << "received: " << received.size() << " of " << expected.size() << std::endl;
+	std::cout << "each value exactly once: " << std::boolalpha << (received == expected) << std::endl;
+	std::cout << "producer order kept: " << std::boolalpha << ordered << std::endl;
+	std::cout << "empty at the end: " << std::boolalpha << queue.empty() << std::endl;
+}
+
+void test_bounds()
+{
+	Mpmc_queue<std::string> queue(3);
+	std::string value = "a string longer than the small string buffer";
+	unsigned pushed = 0;
+	while (queue.try_push(std::string(value)))
+	{
+		++pushed;
+	}
+	const bool kept = queue.try_push(value) == false && !value.empty();
+	std::cout << "capacity: " << queue.capacity() << ", pushed: " << pushed << std::endl;
+	std::cout << "full: " << std::boolalpha << queue.full() << std::endl;
+	std::cout << "rejected value left untouched: " << std::boolalpha << kept << std::endl;
+	std::string popped;
+	queue.try_pop(popped);
+	std::cout << "popped the value pushed: " << std::boolalpha << (popped == value) << std::endl;
+	// The values left are destroyed with the queue
+}
+
+int main()
+{
+	// Test the capacity and the non-blocking operations, with a type owning memory
+	test_bounds();
+	std::cout << "\n\n";
+
+	// Test with a small queue, producers and consumers often wait for each other
+	test(1, 1, 100000, 2);
+	std::cout << "\n\n";
+
+	// Test with several producers and consumers
+	test(4, 4, 100000, 64);
+	std::cout << "\n\n";
+
+	// Test with more consumers than producers
+	test(2, 6, 100000, 1024);
+}